@@ -0,0 +1,495 @@
+#include "pcomb.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// This file is a self-contained benchmark harness for pcomb. It generates deterministic inputs for a few representative grammars and reports throughput, allocations per parse and peak RSS.
+// Usage: bench [grammar...] [--sizes 1K,1M,...] [--min-time seconds]
+// Grammars are calc, json, csv and config. All of them run if none is given. Sizes accept K, M and G suffixes and go up to 1G.
+
+using namespace pcomb;
+
+// Allocation counting. The array and nothrow forms of new and delete forward to these. The deallocation functions are kept out of line, since GCC warns about a free() it sees inlined next to an operator new.
+static std::uint64_t numAllocations = 0;
+
+void* operator new(std::size_t size)
+{
+	++numAllocations;
+	if (auto p = std::malloc(size == 0 ? 1 : size))
+		return p;
+	throw std::bad_alloc();
+}
+__attribute__((noinline)) void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+__attribute__((noinline)) void operator delete(void* p, std::size_t) noexcept
+{
+	std::free(p);
+}
+
+#if defined(__cpp_aligned_new)
+// Over-aligned types get their own overloads when the harness is built as C++17 or later
+void* operator new(std::size_t size, std::align_val_t align)
+{
+	++numAllocations;
+	auto p = static_cast<void*>(nullptr);
+	auto alignment = std::max(static_cast<std::size_t>(align), sizeof(void*));
+	if (posix_memalign(&p, alignment, size == 0 ? 1 : size) == 0)
+		return p;
+	throw std::bad_alloc();
+}
+__attribute__((noinline)) void operator delete(void* p, std::align_val_t) noexcept
+{
+	std::free(p);
+}
+__attribute__((noinline)) void operator delete(void* p, std::size_t, std::align_val_t) noexcept
+{
+	std::free(p);
+}
+#endif
+
+// Deterministic input generators. They all use the same xorshift generator with a fixed seed, so a given size always produces the same input.
+class Random
+{
+private:
+	std::uint64_t state;
+public:
+	Random(): state(0x9E3779B97F4A7C15ull) {}
+
+	std::uint64_t next()
+	{
+		state ^= state << 13;
+		state ^= state >> 7;
+		state ^= state << 17;
+		return state;
+	}
+	unsigned below(unsigned n) { return static_cast<unsigned>(next() % n); }
+};
+
+void genCalcExpr(Random& rng, std::string& out, unsigned depth)
+{
+	auto numTerms = 1 + rng.below(4);
+	for (auto i = 0u; i < numTerms; ++i)
+	{
+		if (i != 0)
+		{
+			out += ' ';
+			out += "+-*"[rng.below(3)];
+			out += ' ';
+		}
+		if (depth < 4 && rng.below(4) == 0)
+		{
+			out += '(';
+			genCalcExpr(rng, out, depth + 1);
+			out += ')';
+		}
+		else
+			out += std::to_string(rng.below(1000));
+	}
+}
+
+std::string genCalc(std::size_t size)
+{
+	auto rng = Random();
+	auto out = std::string();
+	out.reserve(size + 64);
+	genCalcExpr(rng, out, 0);
+	while (out.size() < size)
+	{
+		out += " + ";
+		genCalcExpr(rng, out, 0);
+	}
+	return out;
+}
+
+void genJSONValue(Random& rng, std::string& out, unsigned depth, unsigned indent)
+{
+	auto kind = depth < 5 ? rng.below(7) : 4 + rng.below(3);
+	auto newline = [&] (unsigned level)
+	{
+		out += '\n';
+		out.append(level * 2, ' ');
+	};
+
+	switch (kind)
+	{
+		case 0:
+		case 1:
+		{
+			out += '{';
+			auto n = rng.below(5);
+			for (auto i = 0u; i < n; ++i)
+			{
+				if (i != 0)
+					out += ',';
+				newline(indent + 1);
+				out += "\"key" + std::to_string(rng.below(100)) + "\": ";
+				genJSONValue(rng, out, depth + 1, indent + 1);
+			}
+			if (n != 0)
+				newline(indent);
+			out += '}';
+			break;
+		}
+		case 2:
+		case 3:
+		{
+			out += '[';
+			auto n = rng.below(5);
+			for (auto i = 0u; i < n; ++i)
+			{
+				if (i != 0)
+					out += ", ";
+				genJSONValue(rng, out, depth + 1, indent + 1);
+			}
+			out += ']';
+			break;
+		}
+		case 4:
+			out += "\"str" + std::to_string(rng.below(100000)) + (rng.below(4) == 0 ? "\\\"esc\\\"" : "") + "\"";
+			break;
+		case 5:
+			out += std::to_string(static_cast<int>(rng.below(200000)) - 100000);
+			if (rng.below(2) == 0)
+				out += "." + std::to_string(rng.below(1000)) + "e" + std::to_string(rng.below(10));
+			break;
+		default:
+		{
+			static const char* const keywords[] = { "true", "false", "null" };
+			out += keywords[rng.below(3)];
+			break;
+		}
+	}
+}
+
+std::string genJSON(std::size_t size)
+{
+	auto rng = Random();
+	auto out = std::string("[");
+	out.reserve(size + 1024);
+	while (out.size() < size)
+	{
+		if (out.size() > 1)
+			out += ",";
+		out += "\n  ";
+		genJSONValue(rng, out, 1, 1);
+	}
+	out += "\n]\n";
+	return out;
+}
+
+std::string genCSV(std::size_t size)
+{
+	auto rng = Random();
+	auto out = std::string();
+	out.reserve(size + 256);
+	while (out.size() < size)
+	{
+		auto numFields = 8u;
+		for (auto i = 0u; i < numFields; ++i)
+		{
+			if (i != 0)
+				out += ',';
+			if (i % 3 == 0)
+				out += "name" + std::to_string(rng.below(10000));
+			else
+				out += std::to_string(rng.below(1000000));
+		}
+		out += '\n';
+	}
+	return out;
+}
+
+std::string genConfig(std::size_t size)
+{
+	auto rng = Random();
+	auto out = std::string();
+	out.reserve(size + 256);
+	auto section = 0u;
+	while (out.size() < size)
+	{
+		out += "\n\n[section" + std::to_string(section++) + "]\n\n";
+		auto numKeys = 1 + rng.below(12);
+		for (auto i = 0u; i < numKeys; ++i)
+		{
+			out.append(4 + rng.below(16), ' ');
+			out += "key" + std::to_string(i);
+			out.append(1 + rng.below(24), ' ');
+			out += '=';
+			out.append(1 + rng.below(8), rng.below(2) == 0 ? ' ' : '\t');
+			if (rng.below(2) == 0)
+				out += "\"value " + std::to_string(rng.below(100000)) + "\"";
+			else
+				out += std::to_string(rng.below(100000));
+			out.append(rng.below(8), ' ');
+			out += '\n';
+			if (rng.below(4) == 0)
+				out += "\n        \n";
+		}
+	}
+	return out;
+}
+
+// Grammars. Their attributes are small summaries of the input rather than full trees, so that the numbers measure parsing instead of tree building.
+
+// calc: evaluates the expression
+auto calcNum = token(integer<long>());
+auto calcExpr0 = LazyParser<long>();
+auto calcAtom = alt(
+	calcNum,
+	rule(seq(ignore(token(ch('('))), calcExpr0.getRef(), ignore(token(ch(')')))), [] (auto single) { return std::get<0>(single); })
+);
+auto calcApply = [] (long lhs, char op, long rhs)
+{
+	switch (op)
+	{
+		case '+': return lhs + rhs;
+		case '-': return lhs - rhs;
+		default: return lhs * rhs;
+	}
+};
+auto calcFactor = chainl1(calcAtom, token(ch('*')), calcApply);
+auto calcTerm = chainl1(calcFactor, alt(token(ch('+')), token(ch('-'))), calcApply);
+auto calcExpr = calcExpr0.setParser(calcTerm);
+auto calcParser = bigstr(calcExpr);
+
+// json: counts the values
+auto jsonValue0 = LazyParser<std::size_t>();
+auto jsonString = token(regex("\"([^\"\\\\]|\\\\.)*\""));
+auto jsonScalar = rule(
+	alt(
+		jsonString,
+		token(regex("-?(0|[1-9][0-9]*)(\\.[0-9]+)?([eE][+-]?[0-9]+)?")),
+		rule(token(oneOf({ "true", "false", "null" })), [] (auto kw) { return kw.first; })
+	),
+	[] (auto) { return std::size_t(1); }
+);
+auto jsonSum = [] (auto pair)
+{
+	auto sum = std::get<0>(pair);
+	for (auto const& single: std::get<1>(pair))
+		sum += std::get<0>(single);
+	return sum;
+};
+auto jsonMember = rule(seq(ignore(jsonString), ignore(token(ch(':'))), jsonValue0.getRef()), [] (auto single) { return std::get<0>(single); });
+auto jsonObject = rule(
+	seq(
+		ignore(token(ch('{'))),
+		alt(rule(seq(jsonMember, many(seq(ignore(token(ch(','))), jsonMember))), jsonSum), rule(str(""), [] (auto) { return std::size_t(0); })),
+		ignore(token(ch('}')))
+	),
+	[] (auto single) { return std::get<0>(single) + 1; }
+);
+auto jsonArray = rule(
+	seq(
+		ignore(token(ch('['))),
+		alt(rule(seq(jsonValue0.getRef(), many(seq(ignore(token(ch(','))), jsonValue0.getRef()))), jsonSum), rule(str(""), [] (auto) { return std::size_t(0); })),
+		ignore(token(ch(']')))
+	),
+	[] (auto single) { return std::get<0>(single) + 1; }
+);
+auto jsonValueAlt = alt(jsonScalar, jsonObject, jsonArray);
+auto jsonValue = jsonValue0.setParser(jsonValueAlt);
+auto jsonParser = bigstr(jsonValue);
+
+// csv: counts the fields
+auto csvField = regex("[^,\\n]*");
+auto csvRecord = rule(
+	seq(csvField, many(seq(ignore(ch(',')), csvField)), ignore(ch('\n'))),
+	[] (auto pair) { return std::get<1>(pair).size() + 1; }
+);
+auto csvParser = endp(rule(many(csvRecord), [] (auto counts)
+{
+	auto sum = std::size_t(0);
+	for (auto n: counts)
+		sum += n;
+	return sum;
+}));
+
+// config: counts the key-value pairs
+auto configSection = rule(seq(ignore(token(ch('['))), token(regex("[A-Za-z0-9_]+")), ignore(token(ch(']')))), [] (auto) { return std::size_t(0); });
+auto configPair = rule(
+	seq(ignore(token(regex("[A-Za-z0-9_]+"))), ignore(token(ch('='))), alt(token(regex("\"[^\"\\n]*\"")), token(regex("[0-9]+")))),
+	[] (auto) { return std::size_t(1); }
+);
+auto configParser = bigstr(rule(many(alt(configSection, configPair)), [] (auto counts)
+{
+	auto sum = std::size_t(0);
+	for (auto n: counts)
+		sum += n;
+	return sum;
+}));
+
+// Harness
+struct Benchmark
+{
+	const char* name;
+	std::string (*generate)(std::size_t);
+	bool (*run)(const std::string&);
+};
+
+template <typename P>
+bool runParser(const P& p, const std::string& input)
+{
+	auto result = p.parse(InputStream(input));
+	return result.success();
+}
+
+std::size_t parseSize(const std::string& str)
+{
+	auto pos = std::size_t(0);
+	auto value = std::stoull(str, &pos);
+	if (pos < str.size())
+	{
+		switch (str[pos])
+		{
+			case 'K': case 'k': value <<= 10; break;
+			case 'M': case 'm': value <<= 20; break;
+			case 'G': case 'g': value <<= 30; break;
+			default: throw std::invalid_argument("Invalid size suffix: " + str);
+		}
+	}
+	return value;
+}
+
+std::string formatSize(std::size_t size)
+{
+	if (size >= (1u << 30) && size % (1u << 30) == 0)
+		return std::to_string(size >> 30) + "G";
+	if (size >= (1u << 20) && size % (1u << 20) == 0)
+		return std::to_string(size >> 20) + "M";
+	if (size >= (1u << 10) && size % (1u << 10) == 0)
+		return std::to_string(size >> 10) + "K";
+	return std::to_string(size);
+}
+
+long peakRSSKiB()
+{
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_maxrss;
+}
+
+// Generate the input, check that it parses, time the parser and print a row of the table. Return false if the input does not parse.
+bool runBenchmark(const Benchmark& bm, std::size_t size, double minTime)
+{
+	auto input = bm.generate(size);
+
+	// One untimed run to check the input and count allocations
+	auto allocsBefore = numAllocations;
+	if (!bm.run(input))
+	{
+		std::cerr << bm.name << ": parsing the generated input of size " << formatSize(size) << " failed\n";
+		return false;
+	}
+	auto allocsPerParse = numAllocations - allocsBefore;
+
+	using Clock = std::chrono::steady_clock;
+	auto iters = 0u;
+	auto start = Clock::now();
+	auto elapsed = 0.0;
+	do
+	{
+		bm.run(input);
+		++iters;
+		elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+	} while (elapsed < minTime);
+
+	auto bytes = static_cast<double>(input.size()) * iters;
+	std::cout << std::left << std::setw(8) << bm.name << std::right << std::setw(8) << formatSize(size) << std::setw(10) << iters
+		<< std::fixed << std::setprecision(2)
+		<< std::setw(12) << bytes / elapsed / (1 << 20)
+		<< std::setw(12) << elapsed * 1e9 / bytes
+		<< std::setw(14) << allocsPerParse
+		<< std::setw(14) << peakRSSKiB() / 1024.0 << "\n";
+	return true;
+}
+
+// The peak RSS of a process never goes down, so every grammar and size is measured in a child process of its own, forked from a parent that holds no input
+bool runBenchmarkInChild(const Benchmark& bm, std::size_t size, double minTime)
+{
+	std::cout.flush();
+	auto pid = fork();
+	if (pid < 0)
+	{
+		std::cerr << "fork failed\n";
+		return false;
+	}
+	if (pid == 0)
+	{
+		auto ok = runBenchmark(bm, size, minTime);
+		std::cout.flush();
+		_exit(ok ? 0 : 1);
+	}
+
+	auto status = 0;
+	if (waitpid(pid, &status, 0) != pid)
+		return false;
+	return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+int main(int argc, char** argv)
+{
+	Benchmark benchmarks[] = {
+		{ "calc", genCalc, [] (const std::string& s) { return runParser(calcParser, s); } },
+		{ "json", genJSON, [] (const std::string& s) { return runParser(jsonParser, s); } },
+		{ "csv", genCSV, [] (const std::string& s) { return runParser(csvParser, s); } },
+		{ "config", genConfig, [] (const std::string& s) { return runParser(configParser, s); } },
+	};
+
+	auto selected = std::vector<std::string>();
+	auto sizes = std::vector<std::size_t>{ 1 << 10, 64 << 10, 1 << 20, 16 << 20 };
+	auto minTime = 0.5;
+	for (auto i = 1; i < argc; ++i)
+	{
+		auto arg = std::string(argv[i]);
+		if (arg == "--sizes" && i + 1 < argc)
+		{
+			sizes.clear();
+			auto list = std::string(argv[++i]);
+			for (std::size_t start = 0, end; start < list.size(); start = end + 1)
+			{
+				end = list.find(',', start);
+				if (end == std::string::npos)
+					end = list.size();
+				sizes.push_back(parseSize(list.substr(start, end - start)));
+			}
+		}
+		else if (arg == "--min-time" && i + 1 < argc)
+			minTime = std::stod(argv[++i]);
+		else
+			selected.push_back(arg);
+	}
+
+	std::cout << std::left << std::setw(8) << "grammar" << std::right << std::setw(8) << "size" << std::setw(10) << "iters" << std::setw(12) << "MB/s" << std::setw(12) << "ns/byte" << std::setw(14) << "allocs/parse" << std::setw(14) << "peakRSS(MB)" << "\n";
+
+	auto failed = false;
+	for (auto const& bm: benchmarks)
+	{
+		if (!selected.empty() && std::find(selected.begin(), selected.end(), bm.name) == selected.end())
+			continue;
+
+		for (auto size: sizes)
+		{
+			if (!runBenchmarkInChild(bm, size, minTime))
+			{
+				failed = true;
+				break;
+			}
+		}
+	}
+
+	return failed ? 1 : 0;
+}
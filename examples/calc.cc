@@ -7,14 +7,14 @@
 
 using namespace pcomb;
 
-// AST definitions
+// AST definitions. The nodes are allocated in the arena of the ParseContext, and all of them are released at once when the context goes away.
 class Expr
 {
 public:
 	virtual long eval() const = 0;
 	virtual ~Expr() = default;
 };
-using ExprPtr = std::unique_ptr<Expr>;
+using ExprPtr = ArenaPtr<Expr>;
 
 class NumExpr: public Expr
 {
@@ -54,59 +54,39 @@ public:
 };
 
 // Grammar of the calculator
-auto inum = rule
-(
-	token(regex("[+-]?\\d+")),
-	[] (auto digits) -> long
-	{
-		return std::stoul(digits.to_string());
-	}
-);
+auto inum = token(integer<long>());
 
 auto expr0 = LazyParser<ExprPtr>();
 
 auto nexpr = alt
 (
-	rule(inum, [] (auto n) -> ExprPtr { return std::make_unique<NumExpr>(n); }),
+	arenaRule(inum, [] (auto n, MonotonicArena* arena) -> ExprPtr { return arenaNew<NumExpr>(arena, n); }),
 	rule
 	(
-		seq(token(ch('(')), expr0.getRef(), token(ch(')'))),
-		[] (auto triple)
+		seq(ignore(token(ch('('))), expr0.getRef(), ignore(token(ch(')')))),
+		[] (auto single)
 		{
-			return std::move(std::get<1>(triple));
+			return std::move(std::get<0>(single));
 		}
 	)
 );
 
-auto factor = rule
-(
-	seq(nexpr, many(seq(alt(token(ch('*')), token(ch('/'))), nexpr))),
-	[] (auto pair) -> ExprPtr
-	{
-		ExprPtr retExpr = std::move(std::get<0>(pair));
-		auto& exprVec = std::get<1>(pair);
-
-		for (auto& pair: exprVec)
-			retExpr = std::make_unique<BinExpr>(std::get<0>(pair), std::move(retExpr), std::move(std::get<1>(pair)));
-
-		return std::move(retExpr);
-	}
-);
-
-auto term = rule
-(
-	seq(factor, many(seq(alt(token(ch('+')), token(ch('-'))), factor))),
-	[] (auto pair) -> ExprPtr
+// Build a BinExpr for the given operator
+auto binExpr(char opCode)
+{
+	return [opCode] (ExprPtr lhs, ExprPtr rhs, MonotonicArena* arena) -> ExprPtr
 	{
-		ExprPtr retExpr = std::move(std::get<0>(pair));
-		auto& factorVec = std::get<1>(pair);
+		return arenaNew<BinExpr>(arena, opCode, std::move(lhs), std::move(rhs));
+	};
+}
 
-		for (auto& pair: factorVec)
-			retExpr = std::make_unique<BinExpr>(std::get<0>(pair), std::move(retExpr), std::move(std::get<1>(pair)));
+auto arithOps = OperatorTable<ExprPtr>()
+	.infix("+", 1, Assoc::Left, binExpr('+'))
+	.infix("-", 1, Assoc::Left, binExpr('-'))
+	.infix("*", 2, Assoc::Left, binExpr('*'))
+	.infix("/", 2, Assoc::Left, binExpr('/'));
 
-		return std::move(retExpr);
-	}
-);
+auto term = operators(nexpr, arithOps);
 
 auto expr = expr0.setParser(term);
 
@@ -114,12 +94,14 @@ auto parser = bigstr(expr);
 
 void parseLine(const std::string& lineStr)
 {
-	InputStream ss(lineStr);
+	ParseContext ctx;
+	InputStream ss(lineStr, &ctx);
 	auto parseResult = parser.parse(ss);
 	if (parseResult.hasError())
 	{
-		auto remainingStream = parseResult.getInputStream();
-		std::cout << "Parsing failed at line " << remainingStream.getLineNumber() << ", column " << remainingStream.getColumnNumber() << "\n";
+		// The context remembers where the parse got furthest before failing, and what it expected there
+		auto errorStream = ss.consume(ctx.getFurthestFailureOffset());
+		std::cout << "Parsing failed at line " << errorStream.getLineNumber() << ", column " << errorStream.getColumnNumber() << ": expected " << ctx.describeExpected() << "\n";
 		return;
 	}
 
@@ -1,9 +1,16 @@
 #ifndef PCOMB_ALT_PARSER_H
 #define PCOMB_ALT_PARSER_H
 
+#include "Context/ParseContext.h"
 #include "Parser/Parser.h"
 
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <memory>
 #include <tuple>
+#include <vector>
 
 namespace pcomb
 {
@@ -34,9 +41,39 @@ public:
 	using type = typename ParserType::OutputType;
 };
 
+// Describe the printable bytes of a first set as expected items, merging runs of consecutive bytes into ranges. Whitespace and control bytes are left out: they are mostly what token() skips before the part worth telling about. A set without printable bytes is described as a character.
+inline std::vector<ExpectedItem> describeFirstSet(const FirstSet& fs)
+{
+	auto const first = 0x21u, last = 0x7eu;
+	auto ret = std::vector<ExpectedItem>();
+	for (auto c = first; c <= last; ++c)
+	{
+		if (!fs.test(static_cast<char>(c)))
+			continue;
+		auto runEnd = c;
+		while (runEnd < last && fs.test(static_cast<char>(runEnd + 1)))
+			++runEnd;
+		if (runEnd == c)
+			ret.push_back(ExpectedItem::character(static_cast<char>(c)));
+		else
+			ret.push_back(ExpectedItem::charRange(static_cast<char>(c), static_cast<char>(runEnd)));
+		c = runEnd;
+	}
+	if (ret.empty())
+	{
+		auto c = 0u;
+		while (c < 256 && !fs.test(static_cast<char>(c)))
+			++c;
+		if (c < 256)
+			ret.push_back(ExpectedItem::label("a character"));
+	}
+	return ret;
+}
+
 }
 
 // The AltParser combinator applies multiple parser (p0, p1, p2, ...) in turn. If p0 succeeds, it returns what p0 returns; otherwise, it tries p1 and return what p1 returns if it succeeds; otherwise, try p2, and so on
+// At construction time AltParser builds a dispatch table from the first sets of its alternatives, which maps the next input byte to the alternatives that can possibly match. Only those are tried.
 template <typename ...Parsers>
 class AltParser: public Parser<typename detail::AltOutputTypeImpl<std::tuple<Parsers...>, sizeof...(Parsers)>::type>
 {
@@ -44,37 +81,166 @@ public:
 	using OutputType = typename detail::AltOutputTypeImpl<std::tuple<Parsers...>, sizeof...(Parsers)>::type;
 	using ResultType = typename Parser<OutputType>::ResultType;
 private:
+	using Candidates = std::bitset<sizeof...(Parsers)>;
+	// dispatch[b] holds the alternatives that may succeed on an input starting with byte b. The last entry is for EOF.
+	using DispatchTable = std::array<Candidates, 257>;
+	auto static constexpr EOFSlot = 256u;
+	// The table and the union of the first sets are computed once and never change, so copies of the combinator (e.g. when it is put inside another one) share them instead of carrying a few kilobytes each
+	struct Dispatch
+	{
+		DispatchTable table;
+		FirstSet firstSet;
+		// What the alternatives skipped at each slot would have expected, as told by their first sets: skippedExpected[skipped[slot]]. Slots that skip the same alternatives share a list, and the first list is the empty one.
+		std::array<uint32_t, 257> skipped;
+		std::vector<std::vector<ExpectedItem>> skippedExpected;
+	};
+
 	std::tuple<Parsers...> parsers;
+	std::shared_ptr<const Dispatch> dispatch;
+
+	static ResultType convertResult(ResultType&& res)
+	{
+		return std::move(res);
+	}
+	template <typename Result>
+	static ResultType convertResult(Result&& res)
+	{
+		if (res.success())
+			return ResultType(std::move(res).getInputStream(), std::move(res).getOutput());
+		return ResultType(std::move(res).getInputStream());
+	}
 
 	template <typename Tuple, size_t I>
 	struct AltNParserImpl
 	{
-		static auto parse(const Tuple& t, const InputStream& input)
+		static ResultType parse(const Tuple& t, const InputStream& input, const Candidates& candidates)
 		{
 			auto constexpr tupleId = std::tuple_size<Tuple>::value - I;
-			auto res = std::get<tupleId>(t).parse(input);
-			if (res.success())
-				return res;
-			else
-				return AltNParserImpl<Tuple, I-1>::parse(t, input);
+			if (candidates.test(tupleId))
+			{
+				// If no later alternative is going to be tried, this failure is the result of the entire combinator
+				if ((candidates >> (tupleId + 1)).none())
+					return convertResult(std::get<tupleId>(t).parse(input));
+				auto res = detail::eventAttempt(eventsOf(input), [&] { return std::get<tupleId>(t).parse(input); });
+				if (res.success())
+					return convertResult(std::move(res));
+			}
+			return AltNParserImpl<Tuple, I-1>::parse(t, input, candidates);
+		}
+
+		static RecognizeResult recognize(const Tuple& t, const InputStream& input, const Candidates& candidates)
+		{
+			auto constexpr tupleId = std::tuple_size<Tuple>::value - I;
+			if (candidates.test(tupleId))
+			{
+				auto res = std::get<tupleId>(t).recognize(input);
+				if (res.success() || (candidates >> (tupleId + 1)).none())
+					return res;
+			}
+			return AltNParserImpl<Tuple, I-1>::recognize(t, input, candidates);
+		}
+
+		static void buildDispatch(const Tuple& t, DispatchTable& table, std::vector<FirstSet>& firstSets)
+		{
+			auto constexpr tupleId = std::tuple_size<Tuple>::value - I;
+			auto fs = std::get<tupleId>(t).getFirstSet();
+			for (auto c = 0u; c < 256; ++c)
+				if (fs.isNullable() || fs.test(static_cast<char>(c)))
+					table[c].set(tupleId);
+			if (fs.isNullable())
+				table[EOFSlot].set(tupleId);
+			firstSets.push_back(fs);
+			AltNParserImpl<Tuple, I-1>::buildDispatch(t, table, firstSets);
 		}
 	};
 
 	template <typename Tuple>
-	struct AltNParserImpl<Tuple, 1>
+	struct AltNParserImpl<Tuple, 0>
 	{
-		static auto parse(const Tuple& t, const InputStream& input)
+		static ResultType parse(const Tuple&, const InputStream& input, const Candidates&)
+		{
+			// None of the alternatives can start with the next byte
+			return ResultType(input);
+		}
+
+		static RecognizeResult recognize(const Tuple&, const InputStream& input, const Candidates&)
 		{
-			auto constexpr tupleId = std::tuple_size<Tuple>::value - 1;
-			return std::get<tupleId>(t).parse(input);
+			return RecognizeResult(input);
 		}
+
+		static void buildDispatch(const Tuple&, DispatchTable&, std::vector<FirstSet>&) {}
 	};
+
+	// Describe what the alternatives skipped at each slot expect, once for every distinct set of skipped alternatives
+	static void buildSkippedExpected(Dispatch& d, const std::vector<FirstSet>& firstSets)
+	{
+		auto skippedSets = std::vector<Candidates>{ Candidates() };
+		d.skippedExpected.emplace_back();
+		for (auto slot = 0u; slot <= EOFSlot; ++slot)
+		{
+			auto skipped = ~d.table[slot];
+			auto itr = std::find(skippedSets.begin(), skippedSets.end(), skipped);
+			if (itr == skippedSets.end())
+			{
+				auto unionSet = FirstSet();
+				for (auto i = 0u; i < firstSets.size(); ++i)
+					if (skipped.test(i))
+						unionSet |= firstSets[i];
+				itr = skippedSets.insert(skippedSets.end(), skipped);
+				d.skippedExpected.push_back(detail::describeFirstSet(unionSet));
+			}
+			d.skipped[slot] = static_cast<uint32_t>(itr - skippedSets.begin());
+		}
+	}
+
+	// The alternatives skipped by the dispatch table did not get the chance to record what they expected. Their first sets tell what they would have expected, which is recorded as one precomputed list, so that they are not run and the failure costs one append at most.
+	void noteSkippedFailures(const InputStream& input, unsigned slot) const
+	{
+		auto const& expected = dispatch->skippedExpected[dispatch->skipped[slot]];
+		if (!expected.empty())
+			noteFailure(input, ExpectedItem::listOf(expected));
+	}
 public:
-	AltParser(Parsers&&... ps): parsers(std::forward_as_tuple(ps...)) {}
+	AltParser(Parsers&&... ps): parsers(std::forward_as_tuple(ps...))
+	{
+		auto d = std::make_shared<Dispatch>();
+		auto firstSets = std::vector<FirstSet>();
+		AltNParserImpl<std::tuple<Parsers...>, sizeof...(Parsers)>::buildDispatch(parsers, d->table, firstSets);
+		for (auto const& fs: firstSets)
+			d->firstSet |= fs;
+		buildSkippedExpected(*d, firstSets);
+		dispatch = std::move(d);
+	}
 
 	ResultType parse(const InputStream& input) const override final
 	{
-		return AltNParserImpl<std::tuple<Parsers...>, sizeof...(Parsers)>::parse(parsers, input);
+		auto slot = input.isEOF() ? EOFSlot : static_cast<unsigned char>(input.getRawBuffer()[0]);
+		// The alternatives skipped at the end of the input would have run out of it
+		if (slot == EOFSlot)
+			noteEndReached(input);
+		auto const& candidates = dispatch->table[slot];
+		auto res = AltNParserImpl<std::tuple<Parsers...>, sizeof...(Parsers)>::parse(parsers, input, candidates);
+		if (res.hasError())
+			noteSkippedFailures(input, slot);
+		return res;
+	}
+
+	RecognizeResult recognize(const InputStream& input) const override final
+	{
+		auto slot = input.isEOF() ? EOFSlot : static_cast<unsigned char>(input.getRawBuffer()[0]);
+		// The alternatives skipped at the end of the input would have run out of it
+		if (slot == EOFSlot)
+			noteEndReached(input);
+		auto const& candidates = dispatch->table[slot];
+		auto res = AltNParserImpl<std::tuple<Parsers...>, sizeof...(Parsers)>::recognize(parsers, input, candidates);
+		if (res.hasError())
+			noteSkippedFailures(input, slot);
+		return res;
+	}
+
+	FirstSet getFirstSet() const override final
+	{
+		return dispatch->firstSet;
 	}
 };
 
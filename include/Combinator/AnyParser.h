@@ -0,0 +1,276 @@
+#ifndef PCOMB_ANY_PARSER_H
+#define PCOMB_ANY_PARSER_H
+
+#include "Parser/Parser.h"
+
+#include <cassert>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace pcomb
+{
+
+namespace detail
+{
+
+// The storage of an AnyParser: the parser itself if it is small enough, a pointer to a heap copy otherwise
+union AnyParserStorage
+{
+	enum : std::size_t { InlineSize = 64 };
+
+	alignas(std::max_align_t) unsigned char buffer[InlineSize];
+	void* heap;
+};
+
+// ParserCalls and AnyParserOps are hand-written vtables for one concrete parser type. Nothing relies on RTTI, which the build turns off.
+template <typename O>
+struct ParserCalls
+{
+	ParseResult<O> (*parse)(const void*, const InputStream&);
+	RecognizeResult (*recognize)(const void*, const InputStream&);
+	FirstSet (*getFirstSet)(const void*);
+};
+
+template <typename O, typename ParserA>
+struct ParserCallsFor
+{
+	static ParseResult<O> parse(const void* p, const InputStream& input)
+	{
+		return static_cast<const ParserA*>(p)->parse(input);
+	}
+	static RecognizeResult recognize(const void* p, const InputStream& input)
+	{
+		return static_cast<const ParserA*>(p)->recognize(input);
+	}
+	static FirstSet getFirstSet(const void* p)
+	{
+		return static_cast<const ParserA*>(p)->getFirstSet();
+	}
+
+	static constexpr ParserCalls<O> calls = { &parse, &recognize, &getFirstSet };
+};
+
+template <typename O, typename ParserA>
+constexpr ParserCalls<O> ParserCallsFor<O, ParserA>::calls;
+
+template <typename O>
+struct AnyParserOps
+{
+	ParserCalls<O> calls;
+	bool onHeap;
+	// Construct a copy of (or move) the parser in src into dst, which holds nothing
+	void (*copy)(const AnyParserStorage& src, AnyParserStorage& dst);
+	void (*move)(AnyParserStorage& src, AnyParserStorage& dst) noexcept;
+	void (*destroy)(AnyParserStorage&) noexcept;
+};
+
+template <typename O, typename ParserA>
+struct AnyParserOpsFor
+{
+	// Parsers whose move may throw go to the heap too, so that moving an AnyParser never throws
+	enum : bool { OnHeap = !(sizeof(ParserA) <= AnyParserStorage::InlineSize && alignof(ParserA) <= alignof(std::max_align_t) && std::is_nothrow_move_constructible<ParserA>::value) };
+
+	static ParserA* get(AnyParserStorage& s)
+	{
+		return OnHeap ? static_cast<ParserA*>(s.heap) : reinterpret_cast<ParserA*>(s.buffer);
+	}
+	static const ParserA* get(const AnyParserStorage& s)
+	{
+		return OnHeap ? static_cast<const ParserA*>(s.heap) : reinterpret_cast<const ParserA*>(s.buffer);
+	}
+
+	template <typename P>
+	static void construct(AnyParserStorage& s, P&& p)
+	{
+		if (OnHeap)
+			s.heap = new ParserA(std::forward<P>(p));
+		else
+			::new (static_cast<void*>(s.buffer)) ParserA(std::forward<P>(p));
+	}
+
+	static void copy(const AnyParserStorage& src, AnyParserStorage& dst)
+	{
+		construct(dst, *get(src));
+	}
+	static void move(AnyParserStorage& src, AnyParserStorage& dst) noexcept
+	{
+		if (OnHeap)
+		{
+			dst.heap = src.heap;
+			src.heap = nullptr;
+		}
+		else
+			::new (static_cast<void*>(dst.buffer)) ParserA(std::move(*get(src)));
+	}
+	static void destroy(AnyParserStorage& s) noexcept
+	{
+		if (OnHeap)
+			delete get(s);
+		else
+			get(s)->~ParserA();
+	}
+
+	static constexpr AnyParserOps<O> ops = { ParserCallsFor<O, ParserA>::calls, OnHeap, &copy, &move, &destroy };
+};
+
+template <typename O, typename ParserA>
+constexpr AnyParserOps<O> AnyParserOpsFor<O, ParserA>::ops;
+
+}	// end of namespace detail
+
+// Whether an AnyParser stores a parser of type ParserA inline, i.e. without a heap allocation
+template <typename ParserA>
+struct IsStoredInline: std::integral_constant<bool, !detail::AnyParserOpsFor<typename ParserA::OutputType, ParserA>::OnHeap> {};
+
+// AnyParser owns a parser of any concrete type with output type O, for grammars that are put together at runtime. Parsers of up to 64 bytes are stored inline and larger ones are copied to the heap. Copying an AnyParser copies the parser it holds.
+// Calls go through one indirect call into code instantiated for the concrete type, where everything below is resolved statically again.
+template <typename O>
+class AnyParser: public Parser<O>
+{
+private:
+	const detail::AnyParserOps<O>* ops;
+	detail::AnyParserStorage storage;
+
+	const void* target() const
+	{
+		return ops->onHeap ? storage.heap : static_cast<const void*>(storage.buffer);
+	}
+
+	void reset() noexcept
+	{
+		if (ops != nullptr)
+			ops->destroy(storage);
+		ops = nullptr;
+	}
+public:
+	using OutputType = O;
+	using ResultType = typename Parser<O>::ResultType;
+
+	// An empty AnyParser must be assigned a parser before it is used
+	AnyParser(): ops(nullptr) {}
+
+	template <typename ParserA, typename = std::enable_if_t<!std::is_same<std::decay_t<ParserA>, AnyParser>::value>>
+	AnyParser(ParserA&& p): ops(&detail::AnyParserOpsFor<O, std::decay_t<ParserA>>::ops)
+	{
+		using ParserType = std::decay_t<ParserA>;
+		static_assert(std::is_base_of<Parser<OutputType>, ParserType>::value, "AnyParser only accepts parser type with the same output type");
+
+		detail::AnyParserOpsFor<O, ParserType>::construct(storage, std::forward<ParserA>(p));
+	}
+
+	AnyParser(const AnyParser& other): ops(other.ops)
+	{
+		if (ops != nullptr)
+			ops->copy(other.storage, storage);
+	}
+	AnyParser(AnyParser&& other) noexcept: ops(other.ops)
+	{
+		if (ops != nullptr)
+		{
+			ops->move(other.storage, storage);
+			other.reset();
+		}
+	}
+
+	AnyParser& operator=(const AnyParser& other)
+	{
+		if (this != &other)
+		{
+			// Copy first, so that *this is left alone if the copy throws
+			auto tmp = AnyParser(other);
+			*this = std::move(tmp);
+		}
+		return *this;
+	}
+	AnyParser& operator=(AnyParser&& other) noexcept
+	{
+		if (this != &other)
+		{
+			reset();
+			ops = other.ops;
+			if (ops != nullptr)
+			{
+				ops->move(other.storage, storage);
+				other.reset();
+			}
+		}
+		return *this;
+	}
+
+	~AnyParser()
+	{
+		reset();
+	}
+
+	bool empty() const { return ops == nullptr; }
+
+	ResultType parse(const InputStream& input) const override final
+	{
+		assert(ops != nullptr && "AnyParser is empty");
+		return ops->calls.parse(target(), input);
+	}
+
+	RecognizeResult recognize(const InputStream& input) const override final
+	{
+		assert(ops != nullptr && "AnyParser is empty");
+		return ops->calls.recognize(target(), input);
+	}
+
+	FirstSet getFirstSet() const override final
+	{
+		assert(ops != nullptr && "AnyParser is empty");
+		return ops->calls.getFirstSet(target());
+	}
+};
+
+// ParserRef is a non-owning counterpart of AnyParser: two pointers that refer to a parser of any concrete type with output type O. The parser must outlive the reference.
+template <typename O>
+class ParserRef: public Parser<O>
+{
+private:
+	const void* target;
+	const detail::ParserCalls<O>* calls;
+public:
+	using OutputType = O;
+	using ResultType = typename Parser<O>::ResultType;
+
+	template <typename ParserA, typename = std::enable_if_t<!std::is_same<ParserA, ParserRef>::value>>
+	ParserRef(const ParserA& p): target(&p), calls(&detail::ParserCallsFor<O, ParserA>::calls)
+	{
+		static_assert(std::is_base_of<Parser<OutputType>, ParserA>::value, "ParserRef only accepts parser type with the same output type");
+	}
+
+	ResultType parse(const InputStream& input) const override final
+	{
+		return calls->parse(target, input);
+	}
+
+	RecognizeResult recognize(const InputStream& input) const override final
+	{
+		return calls->recognize(target, input);
+	}
+
+	FirstSet getFirstSet() const override final
+	{
+		return calls->getFirstSet(target);
+	}
+};
+
+template <typename ParserA>
+auto anyParser(ParserA&& p)
+{
+	using ParserType = std::decay_t<ParserA>;
+	return AnyParser<typename ParserType::OutputType>(std::forward<ParserA>(p));
+}
+
+template <typename ParserA>
+auto parserRef(const ParserA& p)
+{
+	return ParserRef<typename ParserA::OutputType>(p);
+}
+
+}
+
+#endif
@@ -1,6 +1,7 @@
 #ifndef PCOMB_ENSEMBLE_PARSER_H
 #define PCOMB_ENSEMBLE_PARSER_H
 
+#include "Context/ParseContext.h"
 #include "Combinator/TokenParser.h"
 #include "Combinator/LexemeParser.h"
 
@@ -28,13 +29,38 @@ public:
 		{
 			auto resStream = result.getInputStream();
 			if (resStream.isEOF())
+			{
+				// More input would not be the end
+				noteEndReached(resStream);
 				return std::move(result);
-			else
-				return ResultType(resStream);
+			}
+			noteFailure(resStream, ExpectedItem::endOfInput());
+			return ResultType(resStream);
 		}
 		else
 			return std::move(result);
 	}
+
+	RecognizeResult recognize(const InputStream& input) const override final
+	{
+		auto result = pa.recognize(input);
+		if (result.success())
+		{
+			if (result.getInputStream().isEOF())
+			{
+				noteEndReached(result.getInputStream());
+				return result;
+			}
+			noteFailure(result.getInputStream(), ExpectedItem::endOfInput());
+			return RecognizeResult(result.getInputStream());
+		}
+		return result;
+	}
+
+	FirstSet getFirstSet() const override final
+	{
+		return pa.getFirstSet();
+	}
 };
 
 template <typename ParserA>
@@ -44,6 +70,7 @@ auto endp(ParserA&& pa)
 	return EndParser<ParserType>(std::forward<ParserA>(pa));
 }
 
+// file() expects the input to be terminated by an explicit EOF char. A MappedFile has no such terminator; parse it with bigstr() instead.
 template <typename ParserA>
 auto file(ParserA&& pa)
 {
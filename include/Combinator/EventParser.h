@@ -0,0 +1,112 @@
+#ifndef PCOMB_EVENT_PARSER_H
+#define PCOMB_EVENT_PARSER_H
+
+#include "Context/ParseContext.h"
+#include "Parser/Parser.h"
+
+#include <experimental/string_view>
+
+namespace pcomb
+{
+
+// EventRuleParser takes a parser p and brackets the events emitted by the rules inside p with a begin and an end event carrying the given name, when an EventHandler is attached to the ParseContext. The attribute of p is passed through, so the rule can stay where it is in the grammar; grammars written for events usually throw their attributes away with foldMany() or manyInto() rather than build them.
+// Events are only emitted in parser mode: ignore() and matched() run their parser as a recognizer, and no event comes from under them.
+template <typename ParserA>
+class EventRuleParser: public Parser<typename ParserA::OutputType>
+{
+private:
+	static_assert(std::is_base_of<Parser<typename ParserA::OutputType>, ParserA>::value, "EventRuleParser only accepts parser type");
+
+	std::experimental::string_view name;
+	ParserA pa;
+public:
+	using OutputType = typename ParserA::OutputType;
+	using ResultType = typename Parser<OutputType>::ResultType;
+
+	// The name must outlive the parse, as a string literal does
+	EventRuleParser(std::experimental::string_view n, const ParserA& a): name(n), pa(a) {}
+	EventRuleParser(std::experimental::string_view n, ParserA&& a): name(n), pa(std::move(a)) {}
+
+	ResultType parse(const InputStream& input) const override final
+	{
+		auto events = eventsOf(input);
+		if (events == nullptr)
+			return pa.parse(input);
+
+		auto mark = events->mark();
+		events->begin(name, input.getOffset());
+		auto result = pa.parse(input);
+		if (result.success())
+			events->end(name, result.getInputStream().getOffset());
+		else
+			events->rollback(mark);
+		return result;
+	}
+
+	RecognizeResult recognize(const InputStream& input) const override final
+	{
+		return pa.recognize(input);
+	}
+
+	FirstSet getFirstSet() const override final
+	{
+		return pa.getFirstSet();
+	}
+};
+
+// EventValueParser takes a parser p and, when p succeeds, emits a value event with the given name and the slice of the input p consumed
+template <typename ParserA>
+class EventValueParser: public Parser<typename ParserA::OutputType>
+{
+private:
+	static_assert(std::is_base_of<Parser<typename ParserA::OutputType>, ParserA>::value, "EventValueParser only accepts parser type");
+
+	std::experimental::string_view name;
+	ParserA pa;
+public:
+	using OutputType = typename ParserA::OutputType;
+	using ResultType = typename Parser<OutputType>::ResultType;
+
+	EventValueParser(std::experimental::string_view n, const ParserA& a): name(n), pa(a) {}
+	EventValueParser(std::experimental::string_view n, ParserA&& a): name(n), pa(std::move(a)) {}
+
+	ResultType parse(const InputStream& input) const override final
+	{
+		auto result = pa.parse(input);
+		auto events = eventsOf(input);
+		if (events != nullptr && result.success())
+		{
+			auto len = result.getInputStream().getOffset() - input.getOffset();
+			events->value(name, input.getInputStringView().substr(0, len), input.getOffset());
+		}
+		return result;
+	}
+
+	RecognizeResult recognize(const InputStream& input) const override final
+	{
+		return pa.recognize(input);
+	}
+
+	FirstSet getFirstSet() const override final
+	{
+		return pa.getFirstSet();
+	}
+};
+
+template <typename ParserA>
+auto eventRule(std::experimental::string_view name, ParserA&& p)
+{
+	using ParserType = std::remove_reference_t<ParserA>;
+	return EventRuleParser<ParserType>(name, std::forward<ParserA>(p));
+}
+
+template <typename ParserA>
+auto eventValue(std::experimental::string_view name, ParserA&& p)
+{
+	using ParserType = std::remove_reference_t<ParserA>;
+	return EventValueParser<ParserType>(name, std::forward<ParserA>(p));
+}
+
+}
+
+#endif
@@ -0,0 +1,364 @@
+#ifndef PCOMB_FOLD_PARSER_H
+#define PCOMB_FOLD_PARSER_H
+
+#include "Context/ParseContext.h"
+#include "Parser/Parser.h"
+
+#include <cstddef>
+#include <iterator>
+#include <functional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace pcomb
+{
+
+// The FoldManyParser combinator applies p0 repeatedly like ManyParser, but folds the result of each application into an accumulator as soon as it is parsed, instead of collecting them in a vector: the attribute is f(...f(f(init, x1), x2)..., xn).
+// f may take the arena of the ParseContext (nullptr if there is none) as a third argument. If minOccurrence is not reached, the combinator fails.
+template <typename ParserA, typename Acc, typename F>
+class FoldManyParser: public Parser<Acc>
+{
+private:
+	static_assert(std::is_base_of<Parser<typename ParserA::OutputType>, ParserA>::value, "FoldManyParser only accepts parser type");
+
+	ParserA pa;
+	Acc init;
+	F f;
+	unsigned minOccurrence;
+public:
+	using OutputType = Acc;
+	using ResultType = typename Parser<Acc>::ResultType;
+
+	FoldManyParser(ParserA a, Acc i, F fn, unsigned n = 0): pa(std::move(a)), init(std::move(i)), f(std::move(fn)), minOccurrence(n) {}
+
+	ResultType parse(const InputStream& input) const override final
+	{
+		auto arena = arenaOf(input);
+		auto events = eventsOf(input);
+		auto acc = init;
+		auto count = 0u;
+		auto resStream = input;
+
+		while (true)
+		{
+			auto paResult = detail::eventAttempt(events, [&] { return pa.parse(resStream); });
+			if (!paResult.success())
+				break;
+
+			acc = detail::invokeBuilder(f, arena, 0, std::move(acc), std::move(paResult).getOutput());
+			++count;
+			resStream = paResult.getInputStream();
+		}
+
+		ResultType ret(resStream);
+		if (count >= minOccurrence)
+			ret.setOutput(std::move(acc));
+		return ret;
+	}
+
+	RecognizeResult recognize(const InputStream& input) const override final
+	{
+		auto count = 0u;
+		auto resStream = input;
+
+		while (true)
+		{
+			auto paResult = pa.recognize(resStream);
+			if (!paResult.success())
+				break;
+
+			++count;
+			resStream = paResult.getInputStream();
+		}
+
+		RecognizeResult ret(resStream);
+		if (count >= minOccurrence)
+			ret.setOutput(Ignored());
+		return ret;
+	}
+
+	FirstSet getFirstSet() const override final
+	{
+		auto ret = pa.getFirstSet();
+		if (minOccurrence == 0)
+			ret.setNullable(true);
+		return ret;
+	}
+};
+
+namespace detail
+{
+
+// The combiner of chainl1(p, op) and chainr1(p, op), whose op parser returns the binary function itself
+struct ApplyOperatorAttribute
+{
+	template <typename O, typename Op>
+	auto operator()(O&& lhs, Op&& op, O&& rhs) const
+	{
+		return std::forward<Op>(op)(std::forward<O>(lhs), std::forward<O>(rhs));
+	}
+};
+
+}	// end of namespace detail
+
+// The ChainParser combinator parses one or more p0 separated by op, and combines them as they are parsed with f(lhs, attribute of op, rhs), from the left or (if RightAssoc is true) from the right. No vector of (op, operand) pairs is built. If op is not followed by p0, the parse stops right before that op.
+// f may take the arena of the ParseContext as a fourth argument. The right-associative fold collects the operands and operators of the chain first and then folds them from the right, so a long chain does not use up the stack.
+template <typename ParserA, typename OpParser, typename F, bool RightAssoc>
+class ChainParser: public Parser<typename ParserA::OutputType>
+{
+private:
+	static_assert(std::is_base_of<Parser<typename ParserA::OutputType>, ParserA>::value, "ChainParser only accepts parser type");
+	static_assert(std::is_base_of<Parser<typename OpParser::OutputType>, OpParser>::value, "ChainParser only accepts parser type");
+
+	using O = typename ParserA::OutputType;
+
+	ParserA pa;
+	OpParser op;
+	F f;
+
+	ParseResult<O> parseRight(const InputStream& input, MonotonicArena* arena, EventBuffer* events) const
+	{
+		auto first = pa.parse(input);
+		if (!first.success())
+			return first;
+
+		// operands[i] is followed by ops[i]. Nothing is allocated until there is an operator.
+		auto operands = std::vector<O>();
+		auto ops = std::vector<typename OpParser::OutputType>();
+		auto resStream = first.getInputStream();
+		auto last = std::move(first).getOutput();
+		while (true)
+		{
+			// The operator and the operand after it are given up together
+			auto mark = detail::beginEventAttempt(events);
+			auto opResult = op.parse(resStream);
+			if (!opResult.success())
+			{
+				detail::endEventAttempt(events, mark, false);
+				break;
+			}
+			auto rhs = pa.parse(opResult.getInputStream());
+			detail::endEventAttempt(events, mark, rhs.success());
+			if (!rhs.success())
+				break;
+
+			operands.push_back(std::move(last));
+			ops.push_back(std::move(opResult).getOutput());
+			last = std::move(rhs).getOutput();
+			resStream = rhs.getInputStream();
+		}
+
+		auto acc = std::move(last);
+		for (auto i = operands.size(); i-- > 0; )
+			acc = detail::invokeBuilder(f, arena, 0, std::move(operands[i]), std::move(ops[i]), std::move(acc));
+		return ParseResult<O>(resStream, std::move(acc));
+	}
+
+	ParseResult<O> parseLeft(const InputStream& input, MonotonicArena* arena, EventBuffer* events) const
+	{
+		auto lhs = pa.parse(input);
+		if (!lhs.success())
+			return lhs;
+
+		auto acc = std::move(lhs).getOutput();
+		auto resStream = lhs.getInputStream();
+		while (true)
+		{
+			auto mark = detail::beginEventAttempt(events);
+			auto opResult = op.parse(resStream);
+			if (!opResult.success())
+			{
+				detail::endEventAttempt(events, mark, false);
+				break;
+			}
+			auto rhs = pa.parse(opResult.getInputStream());
+			detail::endEventAttempt(events, mark, rhs.success());
+			if (!rhs.success())
+				break;
+
+			acc = detail::invokeBuilder(f, arena, 0, std::move(acc), std::move(opResult).getOutput(), std::move(rhs).getOutput());
+			resStream = rhs.getInputStream();
+		}
+		return ParseResult<O>(resStream, std::move(acc));
+	}
+public:
+	using OutputType = O;
+	using ResultType = typename Parser<O>::ResultType;
+
+	ChainParser(ParserA a, OpParser o, F fn): pa(std::move(a)), op(std::move(o)), f(std::move(fn)) {}
+
+	ResultType parse(const InputStream& input) const override final
+	{
+		return RightAssoc ? parseRight(input, arenaOf(input), eventsOf(input)) : parseLeft(input, arenaOf(input), eventsOf(input));
+	}
+
+	// Both folds accept the same input
+	RecognizeResult recognize(const InputStream& input) const override final
+	{
+		auto paResult = pa.recognize(input);
+		if (!paResult.success())
+			return paResult;
+
+		auto resStream = paResult.getInputStream();
+		while (true)
+		{
+			auto opResult = op.recognize(resStream);
+			if (!opResult.success())
+				break;
+			paResult = pa.recognize(opResult.getInputStream());
+			if (!paResult.success())
+				break;
+			resStream = paResult.getInputStream();
+		}
+		return RecognizeResult(resStream, Ignored());
+	}
+
+	FirstSet getFirstSet() const override final
+	{
+		return pa.getFirstSet();
+	}
+};
+
+namespace detail
+{
+
+// Hand a value to a sink, which is either a callable or an output iterator
+template <typename Sink, typename T>
+auto putToSink(Sink& sink, T&& value, int) -> decltype(sink(std::forward<T>(value)), void())
+{
+	sink(std::forward<T>(value));
+}
+template <typename Sink, typename T>
+void putToSink(Sink& sink, T&& value, long)
+{
+	*sink = std::forward<T>(value);
+	++sink;
+}
+// A sink owned elsewhere, given as std::ref(sink)
+template <typename Sink, typename T>
+void putToSink(std::reference_wrapper<Sink>& sink, T&& value, int)
+{
+	putToSink(sink.get(), std::forward<T>(value), 0);
+}
+
+}	// end of namespace detail
+
+// The ManyIntoParser combinator applies p0 repeatedly like ManyParser, but hands the result of each application to a sink as soon as it is parsed, and returns how many there were. The sink is a callable taking the result, or an output iterator such as std::back_inserter(v).
+// The sink lives in the parser and is used in place, never copied by a parse, so an output iterator carries on where the previous parse left off and the parser must not be used by two threads at once. Pass std::ref(s) to use a sink owned elsewhere, e.g. a large accumulator read after the parse.
+// Results are handed over before the enclosing rules are known to succeed, so a sink used under alt() may see the results of a branch that is later abandoned.
+template <typename ParserA, typename Sink>
+class ManyIntoParser: public Parser<size_t>
+{
+private:
+	static_assert(std::is_base_of<Parser<typename ParserA::OutputType>, ParserA>::value, "ManyIntoParser only accepts parser type");
+
+	ParserA pa;
+	mutable Sink sink;
+	unsigned minOccurrence;
+public:
+	using OutputType = size_t;
+	using ResultType = typename Parser<size_t>::ResultType;
+
+	ManyIntoParser(ParserA a, Sink s, unsigned n = 0): pa(std::move(a)), sink(std::move(s)), minOccurrence(n) {}
+
+	ResultType parse(const InputStream& input) const override final
+	{
+		auto events = eventsOf(input);
+		auto count = size_t(0);
+		auto resStream = input;
+
+		while (true)
+		{
+			auto paResult = detail::eventAttempt(events, [&] { return pa.parse(resStream); });
+			if (!paResult.success())
+				break;
+
+			detail::putToSink(sink, std::move(paResult).getOutput(), 0);
+			++count;
+			resStream = paResult.getInputStream();
+		}
+
+		ResultType ret(resStream);
+		if (count >= minOccurrence)
+			ret.setOutput(count);
+		return ret;
+	}
+
+	RecognizeResult recognize(const InputStream& input) const override final
+	{
+		auto count = 0u;
+		auto resStream = input;
+
+		while (true)
+		{
+			auto paResult = pa.recognize(resStream);
+			if (!paResult.success())
+				break;
+
+			++count;
+			resStream = paResult.getInputStream();
+		}
+
+		RecognizeResult ret(resStream);
+		if (count >= minOccurrence)
+			ret.setOutput(Ignored());
+		return ret;
+	}
+
+	FirstSet getFirstSet() const override final
+	{
+		auto ret = pa.getFirstSet();
+		if (minOccurrence == 0)
+			ret.setNullable(true);
+		return ret;
+	}
+};
+
+template <typename ParserA, typename Acc, typename F>
+auto foldMany(ParserA&& p0, Acc&& init, F&& f, unsigned minOccurrence = 0)
+{
+	using ParserType = std::remove_reference_t<ParserA>;
+	return FoldManyParser<ParserType, std::decay_t<Acc>, std::decay_t<F>>(std::forward<ParserA>(p0), std::forward<Acc>(init), std::forward<F>(f), minOccurrence);
+}
+
+// chainl1(p, op, f) combines with f(lhs, attribute of op, rhs), e.g. chainl1(num, token(ch('-')), [] (long l, char, long r) { return l - r; })
+template <typename ParserA, typename OpParser, typename F>
+auto chainl1(ParserA&& p0, OpParser&& op, F&& f)
+{
+	using ParserType = std::remove_reference_t<ParserA>;
+	using OpParserType = std::remove_reference_t<OpParser>;
+	return ChainParser<ParserType, OpParserType, std::decay_t<F>, false>(std::forward<ParserA>(p0), std::forward<OpParser>(op), std::forward<F>(f));
+}
+
+// chainl1(p, op) combines with the attribute of op, which must be a binary function such as a function pointer
+template <typename ParserA, typename OpParser>
+auto chainl1(ParserA&& p0, OpParser&& op)
+{
+	return chainl1(std::forward<ParserA>(p0), std::forward<OpParser>(op), detail::ApplyOperatorAttribute());
+}
+
+template <typename ParserA, typename OpParser, typename F>
+auto chainr1(ParserA&& p0, OpParser&& op, F&& f)
+{
+	using ParserType = std::remove_reference_t<ParserA>;
+	using OpParserType = std::remove_reference_t<OpParser>;
+	return ChainParser<ParserType, OpParserType, std::decay_t<F>, true>(std::forward<ParserA>(p0), std::forward<OpParser>(op), std::forward<F>(f));
+}
+
+template <typename ParserA, typename OpParser>
+auto chainr1(ParserA&& p0, OpParser&& op)
+{
+	return chainr1(std::forward<ParserA>(p0), std::forward<OpParser>(op), detail::ApplyOperatorAttribute());
+}
+
+template <typename ParserA, typename Sink>
+auto manyInto(ParserA&& p0, Sink&& sink, unsigned minOccurrence = 0)
+{
+	using ParserType = std::remove_reference_t<ParserA>;
+	return ManyIntoParser<ParserType, std::decay_t<Sink>>(std::forward<ParserA>(p0), std::forward<Sink>(sink), minOccurrence);
+}
+
+}
+
+#endif
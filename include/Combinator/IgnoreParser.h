@@ -0,0 +1,50 @@
+#ifndef PCOMB_IGNORE_PARSER_H
+#define PCOMB_IGNORE_PARSER_H
+
+#include "Parser/Parser.h"
+
+namespace pcomb
+{
+
+// IgnoreParser takes a parser p, succeeds or fails as p does, and throws p's attribute away. It is mainly meant for punctuation inside seq(), e.g. seq(ignore(ch('(')), expr, ignore(ch(')'))) returns a 1-tuple.
+// p is run in recognizer mode, so its attribute is never built in the first place.
+template <typename ParserA>
+class IgnoreParser: public Parser<Ignored>
+{
+private:
+	static_assert(std::is_base_of<Parser<typename ParserA::OutputType>, ParserA>::value, "IgnoreParser only accepts parser type");
+
+	ParserA pa;
+public:
+	using OutputType = Ignored;
+	using ResultType = typename Parser<Ignored>::ResultType;
+
+	IgnoreParser(const ParserA& a): pa(a) {}
+	IgnoreParser(ParserA&& a): pa(std::move(a)) {}
+
+	ResultType parse(const InputStream& input) const override final
+	{
+		return pa.recognize(input);
+	}
+
+	RecognizeResult recognize(const InputStream& input) const override final
+	{
+		return pa.recognize(input);
+	}
+
+	FirstSet getFirstSet() const override final
+	{
+		return pa.getFirstSet();
+	}
+};
+
+template <typename ParserA>
+auto ignore(ParserA&& p)
+{
+	using ParserType = std::remove_reference_t<ParserA>;
+	return IgnoreParser<ParserType>(std::forward<ParserA>(p));
+}
+
+}
+
+#endif
@@ -8,25 +8,76 @@
 namespace pcomb
 {
 
-// LazyParser allows the user to declare a parser first before giving its full definitions. This is useful for recursive grammar definitions.
-// It is essentially a pointer to another parser.
+// Every parser calls its sub-parsers through their concrete types, and every parse(), recognize() and getFirstSet() override is final, so the compiler resolves and can inline those calls statically through the whole grammar. LazyParser is the only place where a parser is known by its output type alone.
+// It allows the user to declare a parser first before giving its full definitions. This is useful for recursive grammar definitions.
+
+namespace detail
+{
+
+// The target of a LazyParser, shared with all of its references. The function pointers are instantiated for the concrete type given to setParser(), so a call through the slot is a single indirect call into code where the target's own calls are resolved statically again.
+template <typename O>
+struct LazySlot
+{
+	const void* target = nullptr;
+	ParseResult<O> (*parseFn)(const void*, const InputStream&) = nullptr;
+	RecognizeResult (*recognizeFn)(const void*, const InputStream&) = nullptr;
+
+	template <typename ParserA>
+	static ParseResult<O> parseThunk(const void* p, const InputStream& input)
+	{
+		return static_cast<const ParserA*>(p)->parse(input);
+	}
+
+	template <typename ParserA>
+	static RecognizeResult recognizeThunk(const void* p, const InputStream& input)
+	{
+		return static_cast<const ParserA*>(p)->recognize(input);
+	}
+
+	template <typename ParserA>
+	void set(const ParserA& p)
+	{
+		target = &p;
+		parseFn = &parseThunk<ParserA>;
+		recognizeFn = &recognizeThunk<ParserA>;
+	}
+
+	ParseResult<O> parse(const InputStream& input) const
+	{
+		assert(target != nullptr && "LazyParser used before setParser()");
+		return parseFn(target, input);
+	}
+
+	RecognizeResult recognize(const InputStream& input) const
+	{
+		assert(target != nullptr && "LazyParser used before setParser()");
+		return recognizeFn(target, input);
+	}
+};
+
+}	// end of namespace detail
 
 template <typename O>
 class LazyRefParser: public Parser<O>
 {
 private:
-	const Parser<O>** parser;
+	const detail::LazySlot<O>* slot;
 public:
 	using OutputType = O;
 	using ResultType = typename Parser<O>::ResultType;
 
-	LazyRefParser(const Parser<O>** p): parser(p) {}
+	LazyRefParser(const detail::LazySlot<O>* s): slot(s) {}
 
 	ResultType parse(const InputStream& input) const override final
 	{
-		assert(parser != nullptr);
-		assert(*parser != nullptr);
-		return (*parser)->parse(input);
+		assert(slot != nullptr);
+		return slot->parse(input);
+	}
+
+	RecognizeResult recognize(const InputStream& input) const override final
+	{
+		assert(slot != nullptr);
+		return slot->recognize(input);
 	}
 };
 
@@ -34,29 +85,38 @@ template <typename O>
 class LazyParser: public Parser<O>
 {
 private:
-	std::unique_ptr<const Parser<O>*> parser;
+	std::unique_ptr<detail::LazySlot<O>> slot;
 public:
 	using OutputType = O;
 	using ResultType = typename Parser<O>::ResultType;
 
-	LazyParser(): parser(std::make_unique<const Parser<O>*>(nullptr)) {}
+	LazyParser(): slot(std::make_unique<detail::LazySlot<O>>()) {}
 
-	LazyRefParser<O> setParser(const Parser<OutputType>& p)
+	// p is referenced, not copied, so it must outlive the LazyParser and its references
+	template <typename ParserA>
+	LazyRefParser<O> setParser(const ParserA& p)
 	{
-		*parser = &p;
+		static_assert(std::is_base_of<Parser<OutputType>, ParserA>::value, "LazyParser only accepts parser type");
+
+		slot->set(p);
 		return getRef();
 	}
 
 	LazyRefParser<O> getRef() const
 	{
-		return LazyRefParser<O>(parser.get());
+		return LazyRefParser<O>(slot.get());
+	}
+
+	ResultType parse(const InputStream& input) const override final
+	{
+		assert(slot);
+		return slot->parse(input);
 	}
 
-	ResultType parse(const InputStream& input) const
+	RecognizeResult recognize(const InputStream& input) const override final
 	{
-		assert(parser);
-		assert(*parser != nullptr);
-		return (*parser)->parse(input);
+		assert(slot);
+		return slot->recognize(input);
 	}
 };
 
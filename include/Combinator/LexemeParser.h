@@ -1,9 +1,10 @@
 #ifndef PCOMB_LEXEME_PARSER_H
 #define PCOMB_LEXEME_PARSER_H
 
+#include "InputStream/CharClass.h"
 #include "Parser/Parser.h"
 
-#include <bitset>
+#include <memory>
 
 namespace pcomb
 {
@@ -15,50 +16,42 @@ class LexemeParser: public Parser<typename ParserA::OutputType>
 private:
 	static_assert(std::is_base_of<Parser<typename ParserA::OutputType>, ParserA>::value, "LexemeParser only accepts parser type");
 
-	auto static constexpr CharSize = sizeof(char) * 8;
-
 	ParserA pa;
-	std::bitset<1 << CharSize> charBits;
-
-	void setCharBits(const std::experimental::string_view& whitespaces)
-	{
-		for (auto ch: whitespaces)
-			charBits.set(static_cast<unsigned char>(ch));
-	}
+	std::shared_ptr<const CharClass> whitespaces;
 public:
 	static_assert(std::is_base_of<Parser<typename ParserA::OutputType>, ParserA>::value, "TokenParser only accepts parser type");
 
 	using OutputType = typename Parser<typename ParserA::OutputType>::OutputType;
 	using ResultType = typename Parser<typename ParserA::OutputType>::ResultType;
 
-	LexemeParser(const ParserA& p, const std::experimental::string_view& w): pa(p)
-	{
-		setCharBits(w);
-	}
-	LexemeParser(ParserA&& p, const std::experimental::string_view& w): pa(std::move(p))
-	{
-		setCharBits(w);
-	}
+	LexemeParser(const ParserA& p, const std::experimental::string_view& w): pa(p), whitespaces(detail::sharedCharClass(w)) {}
+	LexemeParser(ParserA&& p, const std::experimental::string_view& w): pa(std::move(p)), whitespaces(detail::sharedCharClass(w)) {}
 
 	ResultType parse(const InputStream& input) const override final
 	{
 		auto result = pa.parse(input);
 		if (result.success())
 		{
-			auto resStream = result.getInputStream();
-			while (!resStream.isEOF())
-			{
-				auto firstChar = resStream.getRawBuffer()[0];
-				if (charBits.test(static_cast<unsigned char>(firstChar)))
-					resStream = resStream.consume(1);
-				else
-					break;
-			}
+			auto resStream = result.getInputStream().skip(*whitespaces);
 			return ResultType(std::move(resStream), std::move(result).getOutput());
 		}
 		else
 			return std::move(result);
 	}
+
+	RecognizeResult recognize(const InputStream& input) const override final
+	{
+		auto result = pa.recognize(input);
+		if (result.success())
+			return RecognizeResult(result.getInputStream().skip(*whitespaces), Ignored());
+		else
+			return result;
+	}
+
+	FirstSet getFirstSet() const override final
+	{
+		return pa.getFirstSet();
+	}
 };
 
 template <typename ParserA>
@@ -1,6 +1,7 @@
 #ifndef PCOMB_MANY_PARSER_H
 #define PCOMB_MANY_PARSER_H
 
+#include "Context/ParseContext.h"
 #include "Parser/Parser.h"
 
 #include <vector>
@@ -8,9 +9,38 @@
 namespace pcomb
 {
 
+namespace detail
+{
+
+// A VectorPolicy tells ManyParser what kind of vector to produce and how to create an empty one
+template <typename T>
+struct HeapVectorPolicy
+{
+	using type = std::vector<T>;
+
+	static type make(const InputStream&)
+	{
+		return type();
+	}
+};
+
+template <typename T>
+struct ArenaVectorPolicy
+{
+	using type = ArenaVector<T>;
+
+	static type make(const InputStream& input)
+	{
+		return type(ArenaAllocator<T>(arenaOf(input)));
+	}
+};
+
+}	// end of namespace detail
+
 // The ManyParser combinator applies one parser p0 repeatedly. The result of each application of p0 is pushed into a vector, which is the result of the entire combinator. If nonEmpty is true, the combinator will fail if the vector is empty.
-template <typename ParserA>
-class ManyParser: Parser<std::vector<typename ParserA::OutputType>>
+// With ArenaVectorPolicy the vector is allocated from the arena of the ParseContext attached to the input (or from the heap if there is none), and must not outlive that context.
+template <typename ParserA, template <typename> class VectorPolicy = detail::HeapVectorPolicy>
+class ManyParser: Parser<typename VectorPolicy<typename ParserA::OutputType>::type>
 {
 private:
 	static_assert(std::is_base_of<Parser<typename ParserA::OutputType>, ParserA>::value, "ManyParser only accepts parser type");
@@ -18,7 +48,7 @@ private:
 	ParserA pa;
 	unsigned minOccurrence;
 public:
-	using OutputType = std::vector<typename ParserA::OutputType>;
+	using OutputType = typename VectorPolicy<typename ParserA::OutputType>::type;
 	using ResultType = typename Parser<OutputType>::ResultType;
 	
 	ManyParser(const ParserA& a, unsigned n = 0): pa(a), minOccurrence(n) {}
@@ -26,12 +56,13 @@ public:
 
 	ResultType parse(const InputStream& input) const override final
 	{
-		auto retVec = OutputType();
+		auto retVec = VectorPolicy<typename ParserA::OutputType>::make(input);
 		auto resStream = input;
+		auto events = eventsOf(input);
 
 		while (true)
 		{
-			auto paResult = pa.parse(resStream);
+			auto paResult = detail::eventAttempt(events, [&] { return pa.parse(resStream); });
 			if (!paResult.success())
 				break;
 
@@ -44,6 +75,117 @@ public:
 			ret.setOutput(std::move(retVec));
 		return ret;
 	}
+
+	RecognizeResult recognize(const InputStream& input) const override final
+	{
+		auto count = 0u;
+		auto resStream = input;
+
+		while (true)
+		{
+			auto paResult = pa.recognize(resStream);
+			if (!paResult.success())
+				break;
+
+			++count;
+			resStream = std::move(paResult).getInputStream();
+		}
+
+		RecognizeResult ret(resStream);
+		if (count >= minOccurrence)
+			ret.setOutput(Ignored());
+		return ret;
+	}
+
+	FirstSet getFirstSet() const override final
+	{
+		auto ret = pa.getFirstSet();
+		if (minOccurrence == 0)
+			ret.setNullable(true);
+		return ret;
+	}
+};
+
+// The SepByParser combinator applies p0 repeatedly, with sep between two applications, and pushes the result of each application of p0 into a vector. The attributes of sep are never built. If sep is not followed by p0, the parse stops right before that sep.
+template <typename ParserA, typename SepParser, template <typename> class VectorPolicy = detail::HeapVectorPolicy>
+class SepByParser: public Parser<typename VectorPolicy<typename ParserA::OutputType>::type>
+{
+private:
+	static_assert(std::is_base_of<Parser<typename ParserA::OutputType>, ParserA>::value, "SepByParser only accepts parser type");
+	static_assert(std::is_base_of<Parser<typename SepParser::OutputType>, SepParser>::value, "SepByParser only accepts parser type");
+
+	ParserA pa;
+	SepParser sep;
+	unsigned minOccurrence;
+
+	// Apply sep then p0 at input, and report whether both succeeded
+	template <typename Result>
+	bool parseNext(const InputStream& input, Result& paResult, EventBuffer* events) const
+	{
+		auto sepResult = sep.recognize(input);
+		if (!sepResult.success())
+			return false;
+		paResult = detail::eventAttempt(events, [&] { return pa.parse(sepResult.getInputStream()); });
+		return paResult.success();
+	}
+public:
+	using OutputType = typename VectorPolicy<typename ParserA::OutputType>::type;
+	using ResultType = typename Parser<OutputType>::ResultType;
+
+	SepByParser(ParserA a, SepParser s, unsigned n = 0): pa(std::move(a)), sep(std::move(s)), minOccurrence(n) {}
+
+	ResultType parse(const InputStream& input) const override final
+	{
+		auto retVec = VectorPolicy<typename ParserA::OutputType>::make(input);
+		auto resStream = input;
+
+		auto events = eventsOf(input);
+
+		auto paResult = detail::eventAttempt(events, [&] { return pa.parse(resStream); });
+		if (paResult.success())
+		{
+			do
+			{
+				retVec.emplace_back(std::move(paResult).getOutput());
+				resStream = paResult.getInputStream();
+			} while (parseNext(resStream, paResult, events));
+		}
+
+		ResultType ret(resStream);
+		if (retVec.size() >= minOccurrence)
+			ret.setOutput(std::move(retVec));
+		return ret;
+	}
+
+	RecognizeResult recognize(const InputStream& input) const override final
+	{
+		auto count = 0u;
+		auto resStream = input;
+
+		auto paResult = pa.recognize(resStream);
+		while (paResult.success())
+		{
+			++count;
+			resStream = paResult.getInputStream();
+			auto sepResult = sep.recognize(resStream);
+			if (!sepResult.success())
+				break;
+			paResult = pa.recognize(sepResult.getInputStream());
+		}
+
+		RecognizeResult ret(resStream);
+		if (count >= minOccurrence)
+			ret.setOutput(Ignored());
+		return ret;
+	}
+
+	FirstSet getFirstSet() const override final
+	{
+		auto ret = pa.getFirstSet();
+		if (minOccurrence == 0)
+			ret.setNullable(true);
+		return ret;
+	}
 };
 
 template <typename ParserA>
@@ -53,6 +195,29 @@ auto many(ParserA&& p0, unsigned minOccurrence = 0)
 	return ManyParser<ParserType>(std::forward<ParserA>(p0), minOccurrence);
 }
 
+template <typename ParserA>
+auto arenaMany(ParserA&& p0, unsigned minOccurrence = 0)
+{
+	using ParserType = std::remove_reference_t<ParserA>;
+	return ManyParser<ParserType, detail::ArenaVectorPolicy>(std::forward<ParserA>(p0), minOccurrence);
+}
+
+template <typename ParserA, typename SepParser>
+auto sepBy(ParserA&& p0, SepParser&& sep, unsigned minOccurrence = 0)
+{
+	using ParserType = std::remove_reference_t<ParserA>;
+	using SepParserType = std::remove_reference_t<SepParser>;
+	return SepByParser<ParserType, SepParserType>(std::forward<ParserA>(p0), std::forward<SepParser>(sep), minOccurrence);
+}
+
+template <typename ParserA, typename SepParser>
+auto arenaSepBy(ParserA&& p0, SepParser&& sep, unsigned minOccurrence = 0)
+{
+	using ParserType = std::remove_reference_t<ParserA>;
+	using SepParserType = std::remove_reference_t<SepParser>;
+	return SepByParser<ParserType, SepParserType, detail::ArenaVectorPolicy>(std::forward<ParserA>(p0), std::forward<SepParser>(sep), minOccurrence);
+}
+
 }
 
 #endif
@@ -0,0 +1,59 @@
+#ifndef PCOMB_MATCHED_PARSER_H
+#define PCOMB_MATCHED_PARSER_H
+
+#include "Parser/Parser.h"
+
+#include <experimental/string_view>
+
+namespace pcomb
+{
+
+// MatchedParser takes a parser p, succeeds or fails as p does, and returns the slice of the input p consumed as a string_view, e.g. matched(seq(ident, many(seq(ch('.'), ident)))) returns "a.b.c" as it appears in the input. Whitespace skipped by a token() inside p is part of the slice.
+// p is run in recognizer mode, so its attribute is never built in the first place.
+template <typename ParserA>
+class MatchedParser: public Parser<std::experimental::string_view>
+{
+private:
+	static_assert(std::is_base_of<Parser<typename ParserA::OutputType>, ParserA>::value, "MatchedParser only accepts parser type");
+
+	using StringView = std::experimental::string_view;
+
+	ParserA pa;
+public:
+	using OutputType = StringView;
+	using ResultType = typename Parser<StringView>::ResultType;
+
+	MatchedParser(const ParserA& a): pa(a) {}
+	MatchedParser(ParserA&& a): pa(std::move(a)) {}
+
+	ResultType parse(const InputStream& input) const override final
+	{
+		auto res = pa.recognize(input);
+		if (res.hasError())
+			return ResultType(input);
+
+		auto next = res.getInputStream();
+		return ResultType(next, input.getInputStringView().substr(0, next.getOffset() - input.getOffset()));
+	}
+
+	RecognizeResult recognize(const InputStream& input) const override final
+	{
+		return pa.recognize(input);
+	}
+
+	FirstSet getFirstSet() const override final
+	{
+		return pa.getFirstSet();
+	}
+};
+
+template <typename ParserA>
+auto matched(ParserA&& p)
+{
+	using ParserType = std::remove_reference_t<ParserA>;
+	return MatchedParser<ParserType>(std::forward<ParserA>(p));
+}
+
+}
+
+#endif
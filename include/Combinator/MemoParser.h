@@ -0,0 +1,77 @@
+#ifndef PCOMB_MEMO_PARSER_H
+#define PCOMB_MEMO_PARSER_H
+
+#include "Context/ParseContext.h"
+#include "Parser/Parser.h"
+
+namespace pcomb
+{
+
+// MemoParser caches the result of its sub-parser by input offset, so a rule that gets retried at the same position after backtracking returns immediately (packrat parsing). The cache lives in the ParseContext attached to the input stream. If the input has no context, MemoParser simply forwards to its sub-parser.
+// Cached results are handed out by copy, hence the output type of the sub-parser must be copyable. A cached result would not replay the events of the rules inside, so full parses are not cached while an EventHandler is attached.
+template <typename ParserA>
+class MemoParser: public Parser<typename ParserA::OutputType>
+{
+private:
+	static_assert(std::is_base_of<Parser<typename ParserA::OutputType>, ParserA>::value, "MemoParser only accepts parser type");
+	static_assert(std::is_copy_constructible<typename ParserA::OutputType>::value, "MemoParser requires a copyable output type");
+
+	ParserA pa;
+	// Recognizer results are cached separately from full results, under their own id
+	size_t ruleId, recognizeId;
+public:
+	using OutputType = typename ParserA::OutputType;
+	using ResultType = typename Parser<OutputType>::ResultType;
+
+	MemoParser(const ParserA& a): pa(a), ruleId(detail::nextMemoRuleId()), recognizeId(detail::nextMemoRuleId()) {}
+	MemoParser(ParserA&& a): pa(std::move(a)), ruleId(detail::nextMemoRuleId()), recognizeId(detail::nextMemoRuleId()) {}
+
+	// The id under which this rule shows up in ParseContext::getMemoStats()
+	size_t getRuleId() const { return ruleId; }
+
+	ResultType parse(const InputStream& input) const override final
+	{
+		auto ctx = input.getContext();
+		if (ctx == nullptr || ctx->getEvents() != nullptr)
+			return pa.parse(input);
+
+		auto offset = input.getOffset();
+		if (auto cached = ctx->template lookupMemo<ResultType>(ruleId, offset))
+			return *cached;
+
+		auto result = pa.parse(input);
+		ctx->insertMemo(ruleId, offset, result);
+		return result;
+	}
+
+	RecognizeResult recognize(const InputStream& input) const override final
+	{
+		auto ctx = input.getContext();
+		if (ctx == nullptr)
+			return pa.recognize(input);
+
+		auto offset = input.getOffset();
+		if (auto cached = ctx->template lookupMemo<RecognizeResult>(recognizeId, offset))
+			return *cached;
+
+		auto result = pa.recognize(input);
+		ctx->insertMemo(recognizeId, offset, result);
+		return result;
+	}
+
+	FirstSet getFirstSet() const override final
+	{
+		return pa.getFirstSet();
+	}
+};
+
+template <typename ParserA>
+auto memo(ParserA&& p)
+{
+	using ParserType = std::remove_reference_t<ParserA>;
+	return MemoParser<ParserType>(std::forward<ParserA>(p));
+}
+
+}
+
+#endif
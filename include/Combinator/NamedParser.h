@@ -0,0 +1,90 @@
+#ifndef PCOMB_NAMED_PARSER_H
+#define PCOMB_NAMED_PARSER_H
+
+#include "Context/ParseContext.h"
+#include "Context/Profiler.h"
+#include "Context/Tracer.h"
+#include "Parser/Parser.h"
+
+#include <experimental/string_view>
+
+namespace pcomb
+{
+
+// NamedParser gives a name to the rule p for profiling and tracing. When a Profiler or a Tracer is attached to the ParseContext of the input, every call of p is reported to it; otherwise the only cost is a null check.
+// named() only builds a NamedParser when PCOMB_PROFILE or PCOMB_TRACE is defined, so instrumented grammars cost nothing in builds without them.
+template <typename ParserA>
+class NamedParser: public Parser<typename ParserA::OutputType>
+{
+private:
+	static_assert(std::is_base_of<Parser<typename ParserA::OutputType>, ParserA>::value, "NamedParser only accepts parser type");
+
+	ParserA pa;
+	std::experimental::string_view name;
+	size_t ruleId;
+
+	template <typename Run>
+	auto profile(const InputStream& input, const Run& run) const
+	{
+		auto ctx = input.getContext();
+		if (ctx == nullptr)
+			return run();
+		auto profiler = ctx->getProfiler();
+		auto tracer = ctx->getTracer();
+		if (profiler == nullptr && tracer == nullptr)
+			return run();
+
+		if (tracer != nullptr)
+			tracer->begin(name, input.getOffset());
+		if (profiler != nullptr)
+			profiler->enter(ruleId, name, ctx->getFurthestFailureOffset());
+		auto result = run();
+		if (profiler != nullptr)
+			profiler->exit(result.success(), input.getOffset(), result.getInputStream().getOffset(), ctx->getFurthestFailureOffset());
+		if (tracer != nullptr)
+			tracer->end(name, result.getInputStream().getOffset(), result.success());
+		return result;
+	}
+public:
+	using OutputType = typename ParserA::OutputType;
+	using ResultType = typename Parser<OutputType>::ResultType;
+
+	NamedParser(const std::experimental::string_view& n, const ParserA& a): pa(a), name(n), ruleId(detail::nextNamedRuleId()) {}
+	NamedParser(const std::experimental::string_view& n, ParserA&& a): pa(std::move(a)), name(n), ruleId(detail::nextNamedRuleId()) {}
+
+	const std::experimental::string_view& getName() const { return name; }
+
+	ResultType parse(const InputStream& input) const override final
+	{
+		return profile(input, [&] () { return pa.parse(input); });
+	}
+
+	RecognizeResult recognize(const InputStream& input) const override final
+	{
+		return profile(input, [&] () { return pa.recognize(input); });
+	}
+
+	FirstSet getFirstSet() const override final
+	{
+		return pa.getFirstSet();
+	}
+};
+
+#if defined(PCOMB_PROFILE) || defined(PCOMB_TRACE)
+template <typename ParserA>
+auto named(const std::experimental::string_view& name, ParserA&& p)
+{
+	using ParserType = std::remove_reference_t<ParserA>;
+	return NamedParser<ParserType>(name, std::forward<ParserA>(p));
+}
+#else
+template <typename ParserA>
+std::remove_reference_t<ParserA> named(const std::experimental::string_view&, ParserA&& p)
+{
+	return std::forward<ParserA>(p);
+}
+#endif
+
+}
+
+#endif
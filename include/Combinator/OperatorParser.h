@@ -0,0 +1,403 @@
+#ifndef PCOMB_OPERATOR_PARSER_H
+#define PCOMB_OPERATOR_PARSER_H
+
+#include "Context/ParseContext.h"
+#include "InputStream/CharClass.h"
+#include "Parser/KeywordParser.h"
+#include "Parser/Parser.h"
+
+#include <cassert>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace pcomb
+{
+
+enum class Assoc
+{
+	Left,
+	Right,
+	// a op b op c is not parsed as a whole: the parse stops before the second op
+	None,
+};
+
+namespace detail
+{
+
+template <typename F>
+struct UnaryOperator
+{
+	std::string symbol;
+	unsigned precedence;
+	F build;
+};
+
+template <typename F>
+struct BinaryOperator
+{
+	std::string symbol;
+	unsigned precedence;
+	Assoc assoc;
+	F build;
+};
+
+template <typename Tuple, typename T>
+struct TupleAppend;
+template <typename ...Ts, typename T>
+struct TupleAppend<std::tuple<Ts...>, T>
+{
+	using type = std::tuple<Ts..., T>;
+};
+
+template <typename Tuple, typename T, size_t ...Is>
+typename TupleAppend<Tuple, T>::type tupleAppendImpl(const Tuple& t, T&& x, std::index_sequence<Is...>)
+{
+	return typename TupleAppend<Tuple, T>::type(std::get<Is>(t)..., std::move(x));
+}
+
+template <typename Tuple, typename T>
+typename TupleAppend<Tuple, T>::type tupleAppend(const Tuple& t, T&& x)
+{
+	return tupleAppendImpl(t, std::move(x), std::make_index_sequence<std::tuple_size<Tuple>::value>());
+}
+
+template <typename Tuple, typename F, size_t ...Is>
+void tupleForEachImpl(const Tuple& t, F&& f, std::index_sequence<Is...>)
+{
+	int expand[] = { 0, (f(std::get<Is>(t)), 0)... };
+	(void)expand;
+}
+
+template <typename Tuple, typename F>
+void tupleForEach(const Tuple& t, F&& f)
+{
+	tupleForEachImpl(t, std::forward<F>(f), std::make_index_sequence<std::tuple_size<Tuple>::value>());
+}
+
+// Call f(std::get<i>(t)) for an index i only known at runtime. It is a chain of compares rather than a table of function pointers, so f is inlined for every element.
+template <size_t I, size_t N>
+struct VisitAt
+{
+	template <typename Tuple, typename F>
+	static decltype(auto) visit(const Tuple& t, size_t i, F&& f)
+	{
+		if (i == I)
+			return f(std::get<I>(t));
+		return VisitAt<I + 1, N>::visit(t, i, std::forward<F>(f));
+	}
+};
+template <size_t N>
+struct VisitAt<N, N>
+{
+	template <typename Tuple, typename F>
+	static decltype(auto) visit(const Tuple& t, size_t i, F&& f)
+	{
+		assert(i == N);
+		return f(std::get<N>(t));
+	}
+};
+
+}	// end of namespace detail
+
+// OperatorTable lists the prefix, infix and postfix operators understood by operators(). A larger precedence binds tighter.
+// A builder is called with the operand(s) of its operator, followed by the arena of the ParseContext (nullptr if there is none) if it takes one more argument, and returns the combined value.
+// Every builder keeps its own type, so that reductions are direct calls the compiler can inline: prefix(), infix() and postfix() return a new table with the operator added, and tables are built in one expression, e.g. auto ops = OperatorTable<long>().infix(...).infix(...);
+template <typename O, typename PrefixOps = std::tuple<>, typename InfixOps = std::tuple<>, typename PostfixOps = std::tuple<>>
+class OperatorTable
+{
+private:
+	template <typename, typename, typename, typename>
+	friend class OperatorTable;
+
+	PrefixOps prefixOps;
+	InfixOps infixOps;
+	PostfixOps postfixOps;
+
+	OperatorTable(PrefixOps pre, InfixOps in, PostfixOps post): prefixOps(std::move(pre)), infixOps(std::move(in)), postfixOps(std::move(post)) {}
+public:
+	using OutputType = O;
+	using PrefixOperators = PrefixOps;
+	using InfixOperators = InfixOps;
+	using PostfixOperators = PostfixOps;
+
+	OperatorTable() = default;
+
+	template <typename F>
+	auto prefix(const std::string& symbol, unsigned prec, F&& f) const
+	{
+		assert(!symbol.empty());
+		using Op = detail::UnaryOperator<std::decay_t<F>>;
+		return OperatorTable<O, typename detail::TupleAppend<PrefixOps, Op>::type, InfixOps, PostfixOps>(detail::tupleAppend(prefixOps, Op{ symbol, prec, std::forward<F>(f) }), infixOps, postfixOps);
+	}
+
+	template <typename F>
+	auto infix(const std::string& symbol, unsigned prec, Assoc assoc, F&& f) const
+	{
+		assert(!symbol.empty());
+		using Op = detail::BinaryOperator<std::decay_t<F>>;
+		return OperatorTable<O, PrefixOps, typename detail::TupleAppend<InfixOps, Op>::type, PostfixOps>(prefixOps, detail::tupleAppend(infixOps, Op{ symbol, prec, assoc, std::forward<F>(f) }), postfixOps);
+	}
+
+	template <typename F>
+	auto postfix(const std::string& symbol, unsigned prec, F&& f) const
+	{
+		assert(!symbol.empty());
+		using Op = detail::UnaryOperator<std::decay_t<F>>;
+		return OperatorTable<O, PrefixOps, InfixOps, typename detail::TupleAppend<PostfixOps, Op>::type>(prefixOps, infixOps, detail::tupleAppend(postfixOps, Op{ symbol, prec, std::forward<F>(f) }));
+	}
+
+	const PrefixOps& getPrefixOperators() const { return prefixOps; }
+	const InfixOps& getInfixOperators() const { return infixOps; }
+	const PostfixOps& getPostfixOperators() const { return postfixOps; }
+};
+
+// OperatorParser parses operands given by the atom parser joined by the operators of an OperatorTable, using precedence climbing. The whole expression is parsed in one pass whatever the number of precedence levels, and every operator calls its builder as soon as both of its operands are known, so no intermediate (op, operand) vector is built.
+// Whitespace is skipped before each operator. If an operator is not followed by a valid operand, the parse stops right before that operator, as many(seq(op, operand)) would.
+template <typename AtomParser, typename Table>
+class OperatorParser: public Parser<typename AtomParser::OutputType>
+{
+private:
+	static_assert(std::is_base_of<Parser<typename AtomParser::OutputType>, AtomParser>::value, "OperatorParser only accepts parser type");
+
+	using O = typename AtomParser::OutputType;
+	using PrefixOps = typename Table::PrefixOperators;
+	using InfixOps = typename Table::InfixOperators;
+	using PostfixOps = typename Table::PostfixOperators;
+	static constexpr size_t NumPrefix = std::tuple_size<PrefixOps>::value;
+	static constexpr size_t NumInfix = std::tuple_size<InfixOps>::value;
+	static constexpr size_t NumPostfix = std::tuple_size<PostfixOps>::value;
+
+	// What the climbing loop needs to know about an operator before it decides to apply it
+	struct OperatorInfo
+	{
+		unsigned precedence;
+		Assoc assoc;
+	};
+
+	// Symbols are looked up in two tries: one for the operators that start an operand (prefix), and one for those that follow an operand (infix then postfix)
+	struct Tables
+	{
+		Table table;
+		std::vector<OperatorInfo> prefixInfo, followInfo;
+		std::vector<std::string> prefixSymbols, followSymbols;
+		detail::KeywordTrie prefixTrie, followTrie;
+		// The symbols as expected items, recorded as a whole when an operand or an operator is missing
+		std::vector<ExpectedItem> expectedPrefix, expectedFollow;
+		// Skipped before each operator
+		CharClass whitespaces;
+
+		template <typename Ops>
+		static void collect(const Ops& ops, std::vector<std::string>& symbols, std::vector<OperatorInfo>& infos)
+		{
+			detail::tupleForEach(ops, [&] (auto const& op)
+			{
+				symbols.push_back(op.symbol);
+				infos.push_back(OperatorInfo{ op.precedence, assocOf(op) });
+			});
+		}
+
+		template <typename F>
+		static Assoc assocOf(const detail::BinaryOperator<F>& op) { return op.assoc; }
+		template <typename F>
+		static Assoc assocOf(const detail::UnaryOperator<F>&) { return Assoc::Left; }
+
+		static std::vector<std::string> symbolsOf(const Table& t, bool follow, std::vector<OperatorInfo>& infos)
+		{
+			auto ret = std::vector<std::string>();
+			if (follow)
+			{
+				collect(t.getInfixOperators(), ret, infos);
+				collect(t.getPostfixOperators(), ret, infos);
+			}
+			else
+				collect(t.getPrefixOperators(), ret, infos);
+			return ret;
+		}
+
+		static std::vector<ExpectedItem> expectedOf(const std::vector<std::string>& symbols)
+		{
+			auto ret = std::vector<ExpectedItem>();
+			for (auto const& s: symbols)
+				ret.push_back(ExpectedItem::literal(s));
+			return ret;
+		}
+
+		// The expected items point into the symbol vectors, which are never modified after construction
+		Tables(const Table& t, const std::experimental::string_view& w): table(t), prefixInfo(), followInfo(), prefixSymbols(symbolsOf(t, false, prefixInfo)), followSymbols(symbolsOf(t, true, followInfo)), prefixTrie(prefixSymbols), followTrie(followSymbols), expectedPrefix(expectedOf(prefixSymbols)), expectedFollow(expectedOf(followSymbols)), whitespaces(w) {}
+		Tables(const Tables&) = delete;
+	};
+
+	AtomParser atom;
+	// The table, the tries and the whitespace class are immutable, so copies of the parser can share them
+	std::shared_ptr<const Tables> tables;
+
+	// Build is std::true_type in parser mode and std::false_type in recognizer mode, where neither attributes nor builders are involved
+	template <typename Build>
+	using Attr = std::conditional_t<Build::value, O, Ignored>;
+
+	ParseResult<O> parseAtom(const InputStream& input, std::true_type) const { return atom.parse(input); }
+	RecognizeResult parseAtom(const InputStream& input, std::false_type) const { return atom.recognize(input); }
+
+	// Call the builder of operator i of ops. An empty tuple of operators never matches, so it never gets here.
+	template <typename Ops, typename ...Args>
+	static O apply(const Ops& ops, size_t i, MonotonicArena* arena, std::false_type, Args&&... args)
+	{
+		return detail::VisitAt<0, std::tuple_size<Ops>::value - 1>::visit(ops, i, [&] (auto const& op) -> O
+		{
+			return detail::invokeBuilder(op.build, arena, 0, std::forward<Args>(args)...);
+		});
+	}
+	template <typename Ops, typename Arg, typename ...Args>
+	static O apply(const Ops&, size_t, MonotonicArena*, std::true_type, Arg&& arg, Args&&...)
+	{
+		assert(false && "operator index out of range");
+		return std::forward<Arg>(arg);
+	}
+
+	static O applyPrefix(const Table& t, size_t i, O&& x, MonotonicArena* arena) { return apply(t.getPrefixOperators(), i, arena, std::integral_constant<bool, NumPrefix == 0>(), std::move(x)); }
+	static O applyInfix(const Table& t, size_t i, O&& l, O&& r, MonotonicArena* arena) { return apply(t.getInfixOperators(), i, arena, std::integral_constant<bool, NumInfix == 0>(), std::move(l), std::move(r)); }
+	static O applyPostfix(const Table& t, size_t i, O&& x, MonotonicArena* arena) { return apply(t.getPostfixOperators(), i, arena, std::integral_constant<bool, NumPostfix == 0>(), std::move(x)); }
+	static Ignored applyPrefix(const Table&, size_t, Ignored&&, MonotonicArena*) { return Ignored(); }
+	static Ignored applyInfix(const Table&, size_t, Ignored&&, Ignored&&, MonotonicArena*) { return Ignored(); }
+	static Ignored applyPostfix(const Table&, size_t, Ignored&&, MonotonicArena*) { return Ignored(); }
+
+	// Record the symbols of a list as expected at input, if this is the furthest failure so far. The list is recorded as one item and only expanded if the failure is reported.
+	static void noteExpectedOperators(const InputStream& input, const std::vector<ExpectedItem>& expected)
+	{
+		if (!expected.empty())
+			noteFailure(input, ExpectedItem::listOf(expected));
+	}
+
+	// Parse an expression whose operators all have a precedence of at least minPrec. stop is set when an operator without a valid operand was found, so that the callers up the recursion do not try it again.
+	template <typename Build>
+	ParseResult<Attr<Build>> climb(const InputStream& input, unsigned minPrec, bool& stop) const
+	{
+		using Result = ParseResult<Attr<Build>>;
+		auto const& t = *tables;
+		auto arena = arenaOf(input);
+		// An operator without a valid operand is given up, and so are the events of the attempt. Recognizer mode emits no events.
+		auto events = Build::value ? eventsOf(input) : nullptr;
+
+		auto lhs = Result(input);
+		auto opInput = input.skip(t.whitespaces);
+		auto reachedEnd = false;
+		auto match = t.prefixTrie.longestMatch(opInput.getInputStringView(), reachedEnd);
+		if (reachedEnd)
+			noteEndReached(opInput);
+		if (detail::KeywordTrie::isMatch(match))
+		{
+			auto const& info = t.prefixInfo[match.second];
+			auto operand = detail::eventAttempt(events, [&] { return climb<Build>(opInput.consume(match.first), info.precedence, stop); });
+			if (operand.success())
+			{
+				auto next = operand.getInputStream();
+				lhs = Result(next, applyPrefix(t.table, match.second, std::move(operand).getOutput(), arena));
+			}
+		}
+		// The atom may itself start with a prefix symbol, e.g. a signed number
+		if (lhs.hasError())
+		{
+			lhs = parseAtom(input, Build());
+			if (lhs.hasError())
+			{
+				noteExpectedOperators(opInput, t.expectedPrefix);
+				return Result(input);
+			}
+		}
+
+		// A non-associative operator cannot be followed by another one of the same precedence
+		auto blockedPrec = 0u;
+		auto blocked = false;
+		while (!stop)
+		{
+			opInput = lhs.getInputStream().skip(t.whitespaces);
+			match = t.followTrie.longestMatch(opInput.getInputStringView(), reachedEnd);
+			if (reachedEnd)
+				noteEndReached(opInput);
+			if (!detail::KeywordTrie::isMatch(match))
+			{
+				noteExpectedOperators(opInput, t.expectedFollow);
+				break;
+			}
+
+			auto const& info = t.followInfo[match.second];
+			if (match.second >= NumInfix)
+			{
+				if (info.precedence < minPrec)
+					break;
+				auto next = opInput.consume(match.first);
+				lhs = Result(next, applyPostfix(t.table, match.second - NumInfix, std::move(lhs).getOutput(), arena));
+				continue;
+			}
+
+			if (info.precedence < minPrec || (blocked && info.precedence == blockedPrec))
+				break;
+
+			auto nextMinPrec = info.assoc == Assoc::Right ? info.precedence : info.precedence + 1;
+			auto rhs = detail::eventAttempt(events, [&] { return climb<Build>(opInput.consume(match.first), nextMinPrec, stop); });
+			if (rhs.hasError())
+			{
+				stop = true;
+				break;
+			}
+
+			auto next = rhs.getInputStream();
+			lhs = Result(next, applyInfix(t.table, match.second, std::move(lhs).getOutput(), std::move(rhs).getOutput(), arena));
+			if (info.assoc == Assoc::None)
+			{
+				blocked = true;
+				blockedPrec = info.precedence;
+			}
+			else
+				blocked = false;
+		}
+		return lhs;
+	}
+public:
+	using OutputType = O;
+	using ResultType = typename Parser<OutputType>::ResultType;
+
+	OperatorParser(const AtomParser& a, const Table& t, const std::experimental::string_view& w): atom(a), tables(std::make_shared<Tables>(t, w)) {}
+	OperatorParser(AtomParser&& a, const Table& t, const std::experimental::string_view& w): atom(std::move(a)), tables(std::make_shared<Tables>(t, w)) {}
+
+	ResultType parse(const InputStream& input) const override final
+	{
+		auto stop = false;
+		return climb<std::true_type>(input, 0, stop);
+	}
+
+	RecognizeResult recognize(const InputStream& input) const override final
+	{
+		auto stop = false;
+		return climb<std::false_type>(input, 0, stop);
+	}
+
+	FirstSet getFirstSet() const override final
+	{
+		auto ret = atom.getFirstSet();
+		if (NumPrefix != 0)
+		{
+			ret |= tables->prefixTrie.getFirstSet();
+			for (auto c = 0u; c < 256; ++c)
+				if (tables->whitespaces.test(static_cast<char>(c)))
+					ret.add(static_cast<char>(c));
+		}
+		return ret;
+	}
+};
+
+template <typename AtomParser, typename O, typename PrefixOps, typename InfixOps, typename PostfixOps>
+auto operators(AtomParser&& atom, const OperatorTable<O, PrefixOps, InfixOps, PostfixOps>& table, const std::experimental::string_view& w = " \t\n\v\f\r")
+{
+	using ParserType = std::remove_reference_t<AtomParser>;
+	static_assert(std::is_same<typename ParserType::OutputType, O>::value, "operators() needs a table with the output type of the atom parser");
+	return OperatorParser<ParserType, OperatorTable<O, PrefixOps, InfixOps, PostfixOps>>(std::forward<AtomParser>(atom), table, w);
+}
+
+}
+
+#endif
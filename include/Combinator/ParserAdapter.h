@@ -1,6 +1,7 @@
 #ifndef PCOMB_PARSER_ADAPTER_H
 #define PCOMB_PARSER_ADAPTER_H
 
+#include "Context/ParseContext.h"
 #include "Parser/Parser.h"
 
 namespace pcomb
@@ -31,6 +32,54 @@ public:
 			ret.setOutput(conv(std::move(pResult).getOutput()));
 		return ret;
 	}
+
+	// The converter is not called in recognizer mode
+	RecognizeResult recognize(const InputStream& input) const override final
+	{
+		return pa.recognize(input);
+	}
+
+	FirstSet getFirstSet() const override final
+	{
+		return pa.getFirstSet();
+	}
+};
+
+// ArenaParserAdapter is a ParserAdapter whose converter also receives the arena of the ParseContext attached to the input (nullptr if there is none), so that it can build its result with arenaNew().
+template <typename Converter, typename ParserA>
+class ArenaParserAdapter: public Parser<std::result_of_t<Converter(typename ParserA::OutputType, MonotonicArena*)>>
+{
+private:
+	ParserA pa;
+	Converter conv;
+
+	using AdapterInputType = typename ParserA::OutputType;
+	using AdapterOutputType = std::result_of_t<Converter(AdapterInputType, MonotonicArena*)>;
+public:
+	using OutputType = AdapterOutputType;
+	using ResultType = typename Parser<OutputType>::ResultType;
+
+	template <typename PA, typename C>
+	ArenaParserAdapter(PA&& p, C&& c): pa(std::forward<PA>(p)), conv(std::forward<C>(c)) {}
+
+	ResultType parse(const InputStream& input) const override final
+	{
+		auto pResult = pa.parse(input);
+		auto ret = ResultType(pResult.getInputStream());
+		if (pResult.success())
+			ret.setOutput(conv(std::move(pResult).getOutput(), arenaOf(input)));
+		return ret;
+	}
+
+	RecognizeResult recognize(const InputStream& input) const override final
+	{
+		return pa.recognize(input);
+	}
+
+	FirstSet getFirstSet() const override final
+	{
+		return pa.getFirstSet();
+	}
 };
 
 template <typename Converter, typename ParserA>
@@ -40,6 +89,13 @@ auto rule(ParserA&& p, Converter&& c)
 	return ParserAdapter<Converter, ParserType>(std::forward<ParserA>(p), std::forward<Converter>(c));
 }
 
+template <typename Converter, typename ParserA>
+auto arenaRule(ParserA&& p, Converter&& c)
+{
+	using ParserType = std::remove_reference_t<ParserA>;
+	return ArenaParserAdapter<Converter, ParserType>(std::forward<ParserA>(p), std::forward<Converter>(c));
+}
+
 }
 
 #endif
@@ -1,6 +1,7 @@
 #ifndef PCOMB_SEQ_PARSER_H
 #define PCOMB_SEQ_PARSER_H
 
+#include "Combinator/IgnoreParser.h"
 #include "Parser/Parser.h"
 
 #include <tuple>
@@ -11,7 +12,7 @@ namespace pcomb
 namespace detail
 {
 
-// AttrTypeImpl is a (recursive) template to compute the Attribute type of the seq parser
+// AttrTypeImpl is a (recursive) template to compute the Attribute type of the seq parser. Parsers whose attribute is Ignored do not take a slot in the tuple.
 template <typename Tuple, size_t I>
 struct SeqOutputTypeImpl
 {
@@ -22,28 +23,27 @@ private:
 	static_assert(std::is_base_of<Parser<typename ParserType::OutputType>, ParserType>::value, "SeqParser only accepts parser type");
 	using CurrType = typename ParserType::OutputType;
 public:
-	using type = decltype(
-		std::tuple_cat(
-			std::declval<PrevType>(),
-			std::declval<std::tuple<CurrType>>()
+	using type = std::conditional_t<
+		std::is_same<CurrType, Ignored>::value,
+		PrevType,
+		decltype(
+			std::tuple_cat(
+				std::declval<PrevType>(),
+				std::declval<std::tuple<CurrType>>()
+			)
 		)
-	);
+	>;
 };
 template <typename Tuple>
-struct SeqOutputTypeImpl<Tuple, 1>
+struct SeqOutputTypeImpl<Tuple, 0>
 {
-private:
-	using ParserRefType = std::tuple_element_t<0, Tuple>;
-	using ParserType = std::remove_reference_t<ParserRefType>;
-	static_assert(std::is_base_of<Parser<typename ParserType::OutputType>, ParserType>::value, "SeqParser only accepts parser type");
-	using OutputType = typename ParserType::OutputType;
-public:
-	using type = std::tuple<OutputType>;
+	using type = std::tuple<>;
 };
 
 }
 
 // The SeqParser combinator applies multiple parsers (p0, p1, p2, ...) consequtively. If p0 succeeds, it parse the rest of the input string with (p1, p2, ...). If one of the parsers fails, the entire combinator fails. Otherwise, return the result in a tuple
+// The attributes of the sub-parsers are kept where their results live until the last one succeeds, and are then moved into the result tuple exactly once.
 template <typename ...Parsers>
 class SeqParser: public Parser<typename detail::SeqOutputTypeImpl<std::tuple<Parsers...>, sizeof...(Parsers)>::type>
 {
@@ -51,41 +51,67 @@ public:
 	using OutputType = typename detail::SeqOutputTypeImpl<std::tuple<Parsers...>, sizeof...(Parsers)>::type;
 	using ResultType = typename Parser<OutputType>::ResultType;
 private:
+	using Tuple = std::tuple<Parsers...>;
 	std::tuple<Parsers...> parsers;
 
-	template <typename Tuple, size_t I>
+	// Parse with the I-th parser and onwards. outs are the attributes collected so far.
+	template <size_t I, bool Done = (I == sizeof...(Parsers))>
 	struct SeqNParserImpl
 	{
-		static auto parse(const Tuple& t, const InputStream& input)
+		using ParserType = std::remove_reference_t<std::tuple_element_t<I, Tuple>>;
+		using IsIgnored = std::is_same<typename ParserType::OutputType, Ignored>;
+
+		template <typename ...Outs>
+		static ResultType parse(const Tuple& t, const InputStream& input, Outs&&... outs)
+		{
+			auto res = std::get<I>(t).parse(input);
+			if (!res.success())
+				return ResultType(input);
+			return parseRest(t, res, IsIgnored(), std::forward<Outs>(outs)...);
+		}
+
+		template <typename Result, typename ...Outs>
+		static ResultType parseRest(const Tuple& t, Result& res, std::true_type, Outs&&... outs)
+		{
+			return SeqNParserImpl<I+1>::parse(t, res.getInputStream(), std::forward<Outs>(outs)...);
+		}
+		template <typename Result, typename ...Outs>
+		static ResultType parseRest(const Tuple& t, Result& res, std::false_type, Outs&&... outs)
+		{
+			return SeqNParserImpl<I+1>::parse(t, res.getInputStream(), std::forward<Outs>(outs)..., std::move(res).getOutput());
+		}
+
+		static RecognizeResult recognize(const Tuple& t, const InputStream& input)
+		{
+			auto res = std::get<I>(t).recognize(input);
+			if (!res.success())
+				return RecognizeResult(input);
+			return SeqNParserImpl<I+1>::recognize(t, res.getInputStream());
+		}
+
+		static FirstSet firstSet(const Tuple& t)
 		{
-			auto prevRes = SeqNParserImpl<Tuple, I-1>::parse(t, input);
-
-			using RetType = typename detail::SeqOutputTypeImpl<Tuple, I>::type;
-			auto ret = ParseResult<RetType>(prevRes.getInputStream());
-
-			if (prevRes.success())
-			{
-				auto curRes = std::get<I-1>(t).parse(prevRes.getInputStream());
-				if (curRes.success())
-					ret = ParseResult<RetType>(std::move(curRes).getInputStream(), std::tuple_cat(std::move(prevRes).getOutput(), std::make_tuple(std::move(curRes).getOutput())));
-			}
-			
-			return ret;
+			return std::get<I>(t).getFirstSet().then(SeqNParserImpl<I+1>::firstSet(t));
 		}
 	};
 
-	template <typename Tuple>
-	struct SeqNParserImpl<Tuple, 1>
+	template <size_t I>
+	struct SeqNParserImpl<I, true>
 	{
-		static auto parse(const Tuple& t, const InputStream& input)
+		template <typename ...Outs>
+		static ResultType parse(const Tuple&, const InputStream& input, Outs&&... outs)
+		{
+			return ResultType(input, OutputType(std::forward<Outs>(outs)...));
+		}
+
+		static RecognizeResult recognize(const Tuple&, const InputStream& input)
+		{
+			return RecognizeResult(input, Ignored());
+		}
+
+		static FirstSet firstSet(const Tuple&)
 		{
-			auto res = std::get<0>(t).parse(input);
-			using RetType = typename detail::SeqOutputTypeImpl<Tuple, 1>::type;
-			auto ret = ParseResult<RetType>(input);
-			if (res.success())
-				ret = ParseResult<RetType>(std::move(res).getInputStream(), std::make_tuple(std::move(res).getOutput()));
-			
-			return ret;
+			return FirstSet::empty();
 		}
 	};
 public:
@@ -93,7 +119,17 @@ public:
 
 	ResultType parse(const InputStream& input) const override final
 	{
-		return SeqNParserImpl<std::tuple<Parsers...>, sizeof...(Parsers)>::parse(parsers, input);
+		return SeqNParserImpl<0>::parse(parsers, input);
+	}
+
+	RecognizeResult recognize(const InputStream& input) const override final
+	{
+		return SeqNParserImpl<0>::recognize(parsers, input);
+	}
+
+	FirstSet getFirstSet() const override final
+	{
+		return SeqNParserImpl<0>::firstSet(parsers);
 	}
 };
 
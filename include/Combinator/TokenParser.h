@@ -1,9 +1,10 @@
 #ifndef PCOMB_TOKEN_PARSER_H
 #define PCOMB_TOKEN_PARSER_H
 
+#include "InputStream/CharClass.h"
 #include "Parser/Parser.h"
 
-#include <bitset>
+#include <memory>
 
 namespace pcomb
 {
@@ -15,44 +16,34 @@ class TokenParser: public Parser<typename ParserA::OutputType>
 private:
 	static_assert(std::is_base_of<Parser<typename ParserA::OutputType>, ParserA>::value, "TokenParser only accepts parser type");
 
-	auto static constexpr CharSize = sizeof(char) * 8;
-
 	ParserA pa;
-	std::bitset<1 << CharSize> charBits;
-
-	void setCharBits(const std::experimental::string_view& whitespaces)
-	{
-		for (auto ch: whitespaces)
-			charBits.set(static_cast<unsigned char>(ch));
-	}
+	std::shared_ptr<const CharClass> whitespaces;
 public:
 	static_assert(std::is_base_of<Parser<typename ParserA::OutputType>, ParserA>::value, "TokenParser only accepts parser type");
 
 	using OutputType = typename Parser<typename ParserA::OutputType>::OutputType;
 	using ResultType = typename Parser<typename ParserA::OutputType>::ResultType;
 
-	TokenParser(const ParserA& p, const std::experimental::string_view& w): pa(p)
+	TokenParser(const ParserA& p, const std::experimental::string_view& w): pa(p), whitespaces(detail::sharedCharClass(w)) {}
+	TokenParser(ParserA&& p, const std::experimental::string_view& w): pa(std::move(p)), whitespaces(detail::sharedCharClass(w)) {}
+
+	ResultType parse(const InputStream& input) const override final
 	{
-		setCharBits(w);
+		return pa.parse(input.skip(*whitespaces));
 	}
-	TokenParser(ParserA&& p, const std::experimental::string_view& w): pa(std::move(p))
+
+	RecognizeResult recognize(const InputStream& input) const override final
 	{
-		setCharBits(w);
+		return pa.recognize(input.skip(*whitespaces));
 	}
 
-	ResultType parse(const InputStream& input) const override final
+	FirstSet getFirstSet() const override final
 	{
-		auto resStream = input;
-
-		while (!resStream.isEOF())
-		{
-			auto firstChar = resStream.getRawBuffer()[0];
-			if (charBits.test(static_cast<unsigned char>(firstChar)))
-				resStream = resStream.consume(1);
-			else
-				break;
-		}
-		return pa.parse(resStream);
+		auto ret = pa.getFirstSet();
+		for (auto c = 0u; c < 256; ++c)
+			if (whitespaces->test(static_cast<char>(c)))
+				ret.add(static_cast<char>(c));
+		return ret;
 	}
 };
 
@@ -0,0 +1,202 @@
+#ifndef PCOMB_ARENA_H
+#define PCOMB_ARENA_H
+
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace pcomb
+{
+
+// MonotonicArena hands out memory by bumping a pointer through a list of chunks. Nothing is freed individually: everything allocated from the arena goes away in one shot when the arena is reset or destroyed. Objects with non-trivial destructors created through create() are destroyed at that point, in reverse order of creation.
+class MonotonicArena
+{
+private:
+	struct Chunk
+	{
+		Chunk* next;
+		size_t size;
+	};
+	struct DtorNode
+	{
+		void (*dtor)(void*);
+		void* obj;
+		DtorNode* next;
+	};
+
+	auto static constexpr ChunkAlign = alignof(std::max_align_t);
+	auto static constexpr HeaderSize = (sizeof(Chunk) + ChunkAlign - 1) / ChunkAlign * ChunkAlign;
+	auto static constexpr MaxChunkSize = size_t(1) << 20;
+
+	Chunk* chunks;
+	DtorNode* dtors;
+	char* cur;
+	char* end;
+	size_t initChunkSize, nextChunkSize;
+	size_t bytesAllocated;
+
+	void grow(size_t n, size_t align)
+	{
+		auto size = nextChunkSize;
+		while (size < n + align)
+			size *= 2;
+		if (nextChunkSize < MaxChunkSize)
+			nextChunkSize *= 2;
+
+		auto chunk = static_cast<Chunk*>(::operator new(HeaderSize + size));
+		chunk->next = chunks;
+		chunk->size = size;
+		chunks = chunk;
+		cur = reinterpret_cast<char*>(chunk) + HeaderSize;
+		end = cur + size;
+	}
+
+	template <typename T>
+	static void destroy(void* p)
+	{
+		static_cast<T*>(p)->~T();
+	}
+public:
+	MonotonicArena(size_t chunkSize = 4096): chunks(nullptr), dtors(nullptr), cur(nullptr), end(nullptr), initChunkSize(chunkSize), nextChunkSize(chunkSize), bytesAllocated(0)
+	{
+		assert(chunkSize > 0);
+	}
+	MonotonicArena(const MonotonicArena&) = delete;
+	MonotonicArena& operator=(const MonotonicArena&) = delete;
+	~MonotonicArena()
+	{
+		reset();
+	}
+
+	void* allocate(size_t n, size_t align = alignof(std::max_align_t))
+	{
+		assert(align != 0 && (align & (align - 1)) == 0);
+		auto space = static_cast<size_t>(end - cur);
+		void* ptr = cur;
+		if (cur == nullptr || std::align(align, n, ptr, space) == nullptr)
+		{
+			grow(n, align);
+			ptr = cur;
+			space = static_cast<size_t>(end - cur);
+			std::align(align, n, ptr, space);
+		}
+		cur = static_cast<char*>(ptr) + n;
+		bytesAllocated += n;
+		return ptr;
+	}
+
+	// Construct a T inside the arena. If T needs a destructor, it is run when the arena is reset.
+	template <typename T, typename ...Args>
+	T* create(Args&&... args)
+	{
+		auto obj = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+		if (!std::is_trivially_destructible<T>::value)
+		{
+			auto node = new (allocate(sizeof(DtorNode), alignof(DtorNode))) DtorNode{ &destroy<T>, obj, dtors };
+			dtors = node;
+		}
+		return obj;
+	}
+
+	void reset()
+	{
+		for (auto node = dtors; node != nullptr; node = node->next)
+			node->dtor(node->obj);
+		dtors = nullptr;
+
+		while (chunks != nullptr)
+		{
+			auto next = chunks->next;
+			::operator delete(chunks);
+			chunks = next;
+		}
+		cur = end = nullptr;
+		nextChunkSize = initChunkSize;
+		bytesAllocated = 0;
+	}
+
+	size_t getBytesAllocated() const { return bytesAllocated; }
+};
+
+// ArenaAllocator is a standard allocator that draws from a MonotonicArena. deallocate() is a no-op; the memory is reclaimed when the arena is reset.
+// An ArenaAllocator without an arena falls back to the global heap, so that containers using it work with or without a ParseContext.
+template <typename T>
+class ArenaAllocator
+{
+private:
+	MonotonicArena* arena;
+
+	template <typename U> friend class ArenaAllocator;
+public:
+	using value_type = T;
+	using propagate_on_container_copy_assignment = std::true_type;
+	using propagate_on_container_move_assignment = std::true_type;
+	using propagate_on_container_swap = std::true_type;
+
+	ArenaAllocator(MonotonicArena* a = nullptr): arena(a) {}
+	ArenaAllocator(MonotonicArena& a): arena(&a) {}
+	template <typename U>
+	ArenaAllocator(const ArenaAllocator<U>& other): arena(other.arena) {}
+
+	T* allocate(size_t n)
+	{
+		if (arena == nullptr)
+			return static_cast<T*>(::operator new(n * sizeof(T)));
+		return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T)));
+	}
+	void deallocate(T* p, size_t)
+	{
+		if (arena == nullptr)
+			::operator delete(p);
+	}
+
+	MonotonicArena* getArena() const { return arena; }
+
+	template <typename U>
+	bool operator==(const ArenaAllocator<U>& other) const { return arena == other.arena; }
+	template <typename U>
+	bool operator!=(const ArenaAllocator<U>& other) const { return arena != other.arena; }
+};
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+// ArenaDeleter lets a std::unique_ptr own an object that lives in an arena: it runs the destructor and leaves the memory to the arena. Objects that were allocated on the heap (because there was no arena) are deleted as usual.
+class ArenaDeleter
+{
+private:
+	bool onHeap;
+public:
+	ArenaDeleter(bool h = true): onHeap(h) {}
+
+	template <typename T>
+	void operator()(T* p) const
+	{
+		if (onHeap)
+			delete p;
+		else
+			p->~T();
+	}
+};
+
+// ArenaPtr is the arena counterpart of std::unique_ptr. An ArenaPtr<Derived> converts to an ArenaPtr<Base>, which makes it suitable for AST nodes. It must not outlive the arena it points into.
+template <typename T>
+using ArenaPtr = std::unique_ptr<T, ArenaDeleter>;
+
+// Construct a T in the arena, or on the heap if arena is null
+template <typename T, typename ...Args>
+ArenaPtr<T> arenaNew(MonotonicArena* arena, Args&&... args)
+{
+	if (arena == nullptr)
+		return ArenaPtr<T>(new T(std::forward<Args>(args)...), ArenaDeleter(true));
+	auto mem = arena->allocate(sizeof(T), alignof(T));
+	return ArenaPtr<T>(new (mem) T(std::forward<Args>(args)...), ArenaDeleter(false));
+}
+
+}
+
+#endif
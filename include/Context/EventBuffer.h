@@ -0,0 +1,121 @@
+#ifndef PCOMB_EVENT_BUFFER_H
+#define PCOMB_EVENT_BUFFER_H
+
+#include <cassert>
+#include <cstddef>
+#include <experimental/string_view>
+#include <vector>
+
+namespace pcomb
+{
+
+// EventHandler receives the events of the rules wrapped with eventRule() and eventValue(), in input order, while it is attached to a ParseContext with setEventHandler(). The names are those given to the rules, and the text of a value points into the input.
+class EventHandler
+{
+public:
+	// onBegin(name, offset), onEnd(name, offset) and onValue(name, text, offset), with the offsets of the start of the rule, its end, and the start of the value
+	virtual void onBegin(std::experimental::string_view, size_t) {}
+	virtual void onEnd(std::experimental::string_view, size_t) {}
+	virtual void onValue(std::experimental::string_view, std::experimental::string_view, size_t) {}
+
+	virtual ~EventHandler() = default;
+};
+
+// EventBuffer sits between the parsers and the EventHandler. An event is delivered as soon as it is emitted unless some combinator that recovers from failures (alt() with alternatives left to try, many(), sepBy(), ...) is in the middle of an attempt. Then it is held back until the outermost such attempt is over, and dropped if an attempt it belongs to fails.
+// Memory is thus bounded by the events of the largest attempt, e.g. one element of a top-level array, rather than by the document. A parse that fails as a whole may have delivered the events of its valid prefix, as SAX parsers do.
+class EventBuffer
+{
+private:
+	enum class Kind: unsigned char
+	{
+		Begin,
+		End,
+		Value,
+	};
+	struct Event
+	{
+		Kind kind;
+		std::experimental::string_view name, text;
+		size_t offset;
+	};
+
+	EventHandler* handler;
+	std::vector<Event> pending;
+	// The number of events delivered so far. Marks count both delivered and pending events.
+	size_t delivered;
+	unsigned openAttempts;
+
+	void deliver(const Event& e)
+	{
+		switch (e.kind)
+		{
+			case Kind::Begin:
+				handler->onBegin(e.name, e.offset);
+				break;
+			case Kind::End:
+				handler->onEnd(e.name, e.offset);
+				break;
+			case Kind::Value:
+				handler->onValue(e.name, e.text, e.offset);
+				break;
+		}
+		++delivered;
+	}
+
+	void emit(const Event& e)
+	{
+		if (openAttempts == 0)
+			deliver(e);
+		else
+			pending.push_back(e);
+	}
+public:
+	EventBuffer(): handler(nullptr), delivered(0), openAttempts(0) {}
+
+	void setHandler(EventHandler* h) { handler = h; }
+	EventHandler* getHandler() const { return handler; }
+
+	void begin(std::experimental::string_view name, size_t offset) { emit(Event{ Kind::Begin, name, {}, offset }); }
+	void end(std::experimental::string_view name, size_t offset) { emit(Event{ Kind::End, name, {}, offset }); }
+	void value(std::experimental::string_view name, std::experimental::string_view text, size_t offset) { emit(Event{ Kind::Value, name, text, offset }); }
+
+	size_t mark() const { return delivered + pending.size(); }
+	// The number of events held back, which is what the buffer costs in memory
+	size_t getNumPending() const { return pending.size(); }
+
+	// Drop the events emitted since mark that are still held back
+	void rollback(size_t m)
+	{
+		pending.resize(m > delivered ? m - delivered : 0);
+	}
+
+	// Bracket an attempt that the caller recovers from if it fails
+	size_t beginAttempt()
+	{
+		++openAttempts;
+		return mark();
+	}
+	void endAttempt(size_t m, bool success)
+	{
+		assert(openAttempts > 0);
+		if (!success)
+			rollback(m);
+		if (--openAttempts == 0)
+		{
+			for (auto const& e: pending)
+				deliver(e);
+			pending.clear();
+		}
+	}
+
+	void clear()
+	{
+		pending.clear();
+		delivered = 0;
+		openAttempts = 0;
+	}
+};
+
+}
+
+#endif
@@ -0,0 +1,111 @@
+#ifndef PCOMB_EXPECTED_ITEM_H
+#define PCOMB_EXPECTED_ITEM_H
+
+#include <cstddef>
+#include <experimental/string_view>
+#include <string>
+#include <vector>
+
+namespace pcomb
+{
+
+// ExpectedItem describes something a failed parser was looking for, e.g. the string "else", the char '(' or the end of the input. The failing parsers record them in the ParseContext so that a failed parse can say what was expected where.
+// Literals, patterns and labels refer to text owned by the parsers (or the string literals they were built from), so read them while the grammar is still alive.
+class ExpectedItem
+{
+public:
+	enum class Kind: unsigned char
+	{
+		Literal,
+		Char,
+		CharRange,
+		Pattern,
+		EndOfInput,
+		Label,
+		// A list of items owned by a parser, recorded as one item so that a parser that expects many things (all the operators of a table, say) pays for one append. ParseContext::getExpected() expands it.
+		List,
+	};
+private:
+	Kind kind;
+	char lo, hi;
+	std::experimental::string_view text;
+	const std::vector<ExpectedItem>* list;
+
+	ExpectedItem(Kind k, char l, char h, std::experimental::string_view t, const std::vector<ExpectedItem>* items = nullptr): kind(k), lo(l), hi(h), text(t), list(items) {}
+
+	static std::string quoteChar(char c)
+	{
+		return std::string("'") + c + "'";
+	}
+public:
+	static ExpectedItem literal(std::experimental::string_view s) { return ExpectedItem(Kind::Literal, 0, 0, s); }
+	static ExpectedItem character(char c) { return ExpectedItem(Kind::Char, c, c, {}); }
+	static ExpectedItem charRange(char l, char h) { return ExpectedItem(Kind::CharRange, l, h, {}); }
+	static ExpectedItem pattern(std::experimental::string_view s) { return ExpectedItem(Kind::Pattern, 0, 0, s); }
+	static ExpectedItem endOfInput() { return ExpectedItem(Kind::EndOfInput, 0, 0, {}); }
+	static ExpectedItem label(std::experimental::string_view s) { return ExpectedItem(Kind::Label, 0, 0, s); }
+	static ExpectedItem listOf(const std::vector<ExpectedItem>& items) { return ExpectedItem(Kind::List, 0, 0, {}, &items); }
+
+	Kind getKind() const { return kind; }
+	std::experimental::string_view getText() const { return text; }
+	const std::vector<ExpectedItem>& getList() const { return *list; }
+
+	bool operator==(const ExpectedItem& other) const
+	{
+		return kind == other.kind && lo == other.lo && hi == other.hi && text == other.text && list == other.list;
+	}
+	bool operator!=(const ExpectedItem& other) const { return !(*this == other); }
+
+	std::string toString() const
+	{
+		switch (kind)
+		{
+			case Kind::Literal:
+				return "\"" + text.to_string() + "\"";
+			case Kind::Char:
+				return quoteChar(lo);
+			case Kind::CharRange:
+				return quoteChar(lo) + ".." + quoteChar(hi);
+			case Kind::Pattern:
+				return "/" + text.to_string() + "/";
+			case Kind::EndOfInput:
+				return "end of input";
+			case Kind::Label:
+				return text.to_string();
+			case Kind::List:
+			{
+				auto ret = std::string();
+				for (auto const& item: *list)
+				{
+					if (!ret.empty())
+						ret += ", ";
+					ret += item.toString();
+				}
+				return ret;
+			}
+		}
+		return std::string();
+	}
+};
+
+// Describe a list of expected items, e.g. "one of '(', /[0-9]+/"
+inline std::string describeExpected(const std::vector<ExpectedItem>& items)
+{
+	if (items.empty())
+		return std::string();
+	if (items.size() == 1)
+		return items.front().toString();
+
+	auto ret = std::string("one of ");
+	for (auto i = size_t(0); i < items.size(); ++i)
+	{
+		if (i != 0)
+			ret += ", ";
+		ret += items[i].toString();
+	}
+	return ret;
+}
+
+}
+
+#endif
@@ -0,0 +1,336 @@
+#ifndef PCOMB_PARSE_CONTEXT_H
+#define PCOMB_PARSE_CONTEXT_H
+
+#include "Context/Arena.h"
+#include "Context/EventBuffer.h"
+#include "Context/ExpectedItem.h"
+#include "InputStream/InputStream.h"
+#include "InputStream/LineIndex.h"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace pcomb
+{
+
+class Profiler;
+class TokenArray;
+class Tracer;
+
+namespace detail
+{
+
+// Every memoized rule gets a process-wide unique id when it is constructed. Copies of a rule share the id.
+inline size_t nextMemoRuleId()
+{
+	static std::atomic<size_t> counter(0);
+	return counter++;
+}
+
+}	// end of namespace detail
+
+// ParseContext holds the per-parse state that does not fit into an InputStream: the packrat memo table, an arena for attributes that live as long as the parse, and the furthest failure seen so far. Attach it to the input with InputStream(str, &ctx) and keep it alive until the parse is done. All cached results live in an arena owned by the context, and are released at once when the context is reset or destroyed.
+// A context is tied to a single input buffer, since memo entries are keyed by byte offset. Call reset() before reusing it on a different input.
+class ParseContext
+{
+public:
+	struct MemoStats
+	{
+		size_t hits = 0;
+		size_t misses = 0;
+	};
+private:
+	struct MemoKey
+	{
+		size_t ruleId, offset;
+
+		bool operator==(const MemoKey& other) const
+		{
+			return ruleId == other.ruleId && offset == other.offset;
+		}
+	};
+	struct MemoKeyHash
+	{
+		size_t operator()(const MemoKey& key) const
+		{
+			return std::hash<size_t>()(key.offset * 31 + key.ruleId);
+		}
+	};
+	using MemoTable = std::unordered_map<MemoKey, const void*, MemoKeyHash, std::equal_to<MemoKey>, ArenaAllocator<std::pair<const MemoKey, const void*>>>;
+
+	// arena must be declared before memoTable so that it outlives the table
+	MonotonicArena arena;
+	MemoTable memoTable;
+	std::vector<MemoStats> memoStats;
+
+	// The furthest offset at which a parser failed, and what the parsers that failed there expected. expected may hold duplicates, which are removed when it is read.
+	size_t furthestOffset;
+	std::vector<ExpectedItem> expected;
+	// Whether a parser looked at the end of the input, i.e. whether more input could have changed the result of the parse
+	bool endReached;
+
+	Profiler* profiler;
+	Tracer* tracer;
+	const TokenArray* tokens;
+	EventBuffer events;
+
+	// The line starts of the buffer [lineIndexFirst, lineIndexLast), built the first time a position in it is asked for
+	std::unique_ptr<LineIndex> lineIndex;
+	const char* lineIndexFirst;
+	const char* lineIndexLast;
+
+	MemoStats& getOrCreateStats(size_t ruleId)
+	{
+		if (ruleId >= memoStats.size())
+			memoStats.resize(ruleId + 1);
+		return memoStats[ruleId];
+	}
+public:
+	ParseContext(): memoTable(0, MemoKeyHash(), std::equal_to<MemoKey>(), ArenaAllocator<std::pair<const MemoKey, const void*>>(arena)), furthestOffset(0), endReached(false), profiler(nullptr), tracer(nullptr), tokens(nullptr), lineIndexFirst(nullptr), lineIndexLast(nullptr) {}
+	ParseContext(const ParseContext&) = delete;
+	ParseContext& operator=(const ParseContext&) = delete;
+
+	MonotonicArena& getArena() { return arena; }
+
+	// Return the cached result of rule ruleId at offset, or nullptr if there is none. T must be the result type the rule was cached with.
+	template <typename T>
+	const T* lookupMemo(size_t ruleId, size_t offset)
+	{
+		auto& stats = getOrCreateStats(ruleId);
+		auto itr = memoTable.find(MemoKey{ ruleId, offset });
+		if (itr == memoTable.end())
+		{
+			++stats.misses;
+			return nullptr;
+		}
+		++stats.hits;
+		return static_cast<const T*>(itr->second);
+	}
+
+	template <typename T>
+	const T* insertMemo(size_t ruleId, size_t offset, const T& result)
+	{
+		auto cached = arena.create<T>(result);
+		memoTable[MemoKey{ ruleId, offset }] = cached;
+		return cached;
+	}
+
+	MemoStats getMemoStats(size_t ruleId) const
+	{
+		if (ruleId < memoStats.size())
+			return memoStats[ruleId];
+		return MemoStats();
+	}
+	size_t getMemoHits() const
+	{
+		auto sum = size_t(0);
+		for (auto const& stats: memoStats)
+			sum += stats.hits;
+		return sum;
+	}
+	size_t getMemoMisses() const
+	{
+		auto sum = size_t(0);
+		for (auto const& stats: memoStats)
+			sum += stats.misses;
+		return sum;
+	}
+
+	// Attach a profiler that the rules wrapped with named() report to, or detach it with nullptr. It is not owned by the context, and is kept across reset().
+	void setProfiler(Profiler* p) { profiler = p; }
+	Profiler* getProfiler() const { return profiler; }
+
+	// Attach a tracer that the rules wrapped with named() report to, or detach it with nullptr. It is not owned by the context, and is kept across reset().
+	void setTracer(Tracer* t) { tracer = t; }
+	Tracer* getTracer() const { return tracer; }
+
+	// Attach a handler that the rules wrapped with eventRule() and eventValue() report to, or detach it with nullptr. It is not owned by the context, and is kept across reset().
+	void setEventHandler(EventHandler* h) { events.setHandler(h); }
+	// The event buffer, or nullptr if no handler is attached
+	EventBuffer* getEvents() { return events.getHandler() != nullptr ? &events : nullptr; }
+
+	// The tokens a token-level parse runs over, which tok() looks up the text of its token in. TokenArray::getInputStream() sets it.
+	void setTokens(const TokenArray* t) { tokens = t; }
+	const TokenArray* getTokens() const { return tokens; }
+
+	// The LineIndex of the buffer [first, last), which is built by the first call and reused by the following ones until reset() or a call for another buffer
+	const LineIndex& getLineIndex(const char* first, const char* last)
+	{
+		if (lineIndex == nullptr || first != lineIndexFirst || last != lineIndexLast)
+		{
+			lineIndex.reset(new LineIndex(std::experimental::string_view(first, last - first)));
+			lineIndexFirst = first;
+			lineIndexLast = last;
+		}
+		return *lineIndex;
+	}
+
+	// Whether a failure at offset would be recorded, i.e. whether it is worth finding out what was expected there
+	bool isAtFurthestFailure(size_t offset) const
+	{
+		return offset >= furthestOffset;
+	}
+
+	// Record that a parser expecting item failed at offset. Failures before the furthest one are ignored, and the others cost an append, which keeps the success path (where parsers still fail all the time while backtracking) cheap.
+	void noteFailure(size_t offset, const ExpectedItem& item)
+	{
+		if (offset < furthestOffset)
+			return;
+		if (offset > furthestOffset)
+		{
+			furthestOffset = offset;
+			expected.clear();
+		}
+		expected.push_back(item);
+	}
+
+	// Parsers call this when their result depends on what lies past the end of the input: they ran out of input in the middle of a match, or stopped at the end where more input could have extended their match. parsePartial() tells from it that a parse needs more input.
+	void noteEndReached() { endReached = true; }
+	bool hasReachedEnd() const { return endReached; }
+
+	bool hasFurthestFailure() const { return !expected.empty(); }
+	size_t getFurthestFailureOffset() const { return furthestOffset; }
+
+	// What was expected at the furthest failure, in the order the parsers failed, with lists expanded and without duplicates
+	std::vector<ExpectedItem> getExpected() const
+	{
+		auto ret = std::vector<ExpectedItem>();
+		auto add = [&ret] (const ExpectedItem& item)
+		{
+			if (std::find(ret.begin(), ret.end(), item) == ret.end())
+				ret.push_back(item);
+		};
+		for (auto const& item: expected)
+		{
+			if (item.getKind() != ExpectedItem::Kind::List)
+				add(item);
+			else
+				for (auto const& listed: item.getList())
+					add(listed);
+		}
+		return ret;
+	}
+
+	// Describe what was expected at the furthest failure, e.g. "one of '(', /[0-9]+/"
+	std::string describeExpected() const
+	{
+		return pcomb::describeExpected(getExpected());
+	}
+
+	void reset()
+	{
+		// The table nodes and buckets live in the arena, so the table has to let go of them before the arena is reset
+		MemoTable(0, MemoKeyHash(), std::equal_to<MemoKey>(), memoTable.get_allocator()).swap(memoTable);
+		arena.reset();
+		memoStats.clear();
+		furthestOffset = 0;
+		expected.clear();
+		endReached = false;
+		events.clear();
+		lineIndex.reset();
+	}
+};
+
+// A run that stops at the end of the input might go on in more input
+inline InputStream InputStream::skip(const CharClass& cc) const
+{
+	auto last = str.data() + str.size();
+	auto end = cc.skip(str.data(), last);
+	if (end == last && context != nullptr)
+		context->noteEndReached();
+	return consume(end - str.data());
+}
+
+// A stream only shrinks from the front, so the end of its view is the end of the original buffer
+inline size_t InputStream::getLineNumber() const
+{
+	if (context == nullptr)
+		return detail::countNewlines(base, str.data()) + 1;
+	return context->getLineIndex(base, str.data() + str.size()).getLineNumber(getOffset());
+}
+inline size_t InputStream::getColumnNumber() const
+{
+	if (context == nullptr)
+		return str.data() - detail::findLineStart(base, str.data()) + 1;
+	return context->getLineIndex(base, str.data() + str.size()).getColumnNumber(getOffset());
+}
+
+// Record in the context attached to input, if there is one, that a parser expecting item failed there
+inline void noteFailure(const InputStream& input, const ExpectedItem& item)
+{
+	auto ctx = input.getContext();
+	if (ctx != nullptr)
+		ctx->noteFailure(input.getOffset(), item);
+}
+
+// Record in the context attached to input, if there is one, that a parser looked at the end of input
+inline void noteEndReached(const InputStream& input)
+{
+	auto ctx = input.getContext();
+	if (ctx != nullptr)
+		ctx->noteEndReached();
+}
+
+// Return the arena of the context attached to input, or nullptr if there is none
+inline MonotonicArena* arenaOf(const InputStream& input)
+{
+	auto ctx = input.getContext();
+	return ctx == nullptr ? nullptr : &ctx->getArena();
+}
+
+// Return the event buffer of the context attached to input, or nullptr if there is none or it has no event handler
+inline EventBuffer* eventsOf(const InputStream& input)
+{
+	auto ctx = input.getContext();
+	return ctx == nullptr ? nullptr : ctx->getEvents();
+}
+
+namespace detail
+{
+
+// Bracket an attempt that the caller recovers from if it fails, so that its events are held back until no such attempt is pending and dropped if it fails. events may be nullptr.
+inline size_t beginEventAttempt(EventBuffer* events)
+{
+	return events == nullptr ? 0 : events->beginAttempt();
+}
+inline void endEventAttempt(EventBuffer* events, size_t mark, bool success)
+{
+	if (events != nullptr)
+		events->endAttempt(mark, success);
+}
+
+// Run f as such an attempt
+template <typename F>
+auto eventAttempt(EventBuffer* events, F&& f)
+{
+	if (events == nullptr)
+		return f();
+	auto mark = events->beginAttempt();
+	auto res = f();
+	events->endAttempt(mark, res.success());
+	return res;
+}
+
+// Call a builder with the arena appended to its arguments if it accepts one, and without it otherwise
+template <typename F, typename... Args>
+auto invokeBuilder(const F& f, MonotonicArena* arena, int, Args&&... args) -> decltype(f(std::forward<Args>(args)..., arena))
+{
+	return f(std::forward<Args>(args)..., arena);
+}
+template <typename F, typename... Args>
+auto invokeBuilder(const F& f, MonotonicArena*, long, Args&&... args) -> decltype(f(std::forward<Args>(args)...))
+{
+	return f(std::forward<Args>(args)...);
+}
+
+}	// end of namespace detail
+
+}
+
+#endif
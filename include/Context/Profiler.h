@@ -0,0 +1,217 @@
+#ifndef PCOMB_PROFILER_H
+#define PCOMB_PROFILER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <experimental/string_view>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+namespace pcomb
+{
+
+namespace detail
+{
+
+// Every named rule gets a process-wide unique id when it is constructed. Copies of a rule share the id.
+inline size_t nextNamedRuleId()
+{
+	static std::atomic<size_t> counter(0);
+	return counter++;
+}
+
+// A cheap, monotonic tick count: the time stamp counter on x86, nanoseconds elsewhere
+inline uint64_t readCycleCounter()
+{
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	return __rdtsc();
+#else
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+}	// end of namespace detail
+
+// Profiler collects per-rule statistics from the rules wrapped with named() while it is attached to a ParseContext with setProfiler(). Rules are only instrumented when PCOMB_PROFILE (or PCOMB_TRACE) is defined; otherwise named() returns its parser unchanged and nothing is recorded.
+// Times are in ticks of detail::readCycleCounter(). A Profiler can be attached to several parses in turn, and accumulates over all of them.
+class Profiler
+{
+public:
+	struct RuleStats
+	{
+		std::string name;
+		uint64_t calls = 0;
+		uint64_t successes = 0;
+		uint64_t failures = 0;
+		// Bytes consumed by successful calls
+		uint64_t bytesConsumed = 0;
+		// How far failed calls got past their start before giving up, as told by the furthest failure of the ParseContext. It is a lower bound, since only progress beyond the previous furthest failure is seen.
+		uint64_t bytesBacktracked = 0;
+		// Inclusive time counts recursive calls of a rule once, exclusive time leaves out the time spent in nested named rules
+		uint64_t inclusiveTicks = 0;
+		uint64_t exclusiveTicks = 0;
+		// The number of calls of this rule currently on the stack
+		uint64_t active = 0;
+	};
+private:
+	// The call paths seen so far form a tree of named rules. Node 0 is the root.
+	struct PathNode
+	{
+		size_t parent;
+		size_t ruleId;
+		uint64_t exclusiveTicks;
+		std::vector<std::pair<size_t, size_t>> children;
+	};
+	struct Frame
+	{
+		size_t node;
+		uint64_t start;
+		uint64_t childTicks;
+		size_t furthestBefore;
+	};
+
+	std::vector<RuleStats> rules;
+	std::vector<PathNode> paths;
+	std::vector<Frame> stack;
+
+	size_t getChild(size_t node, size_t ruleId)
+	{
+		for (auto const& child: paths[node].children)
+			if (child.first == ruleId)
+				return child.second;
+		auto ret = paths.size();
+		paths.push_back(PathNode{ node, ruleId, 0, {} });
+		paths[node].children.emplace_back(ruleId, ret);
+		return ret;
+	}
+
+	std::string getPathName(size_t node) const
+	{
+		auto names = std::vector<const std::string*>();
+		for (; node != 0; node = paths[node].parent)
+			names.push_back(&rules[paths[node].ruleId].name);
+
+		auto ret = std::string();
+		for (auto itr = names.rbegin(); itr != names.rend(); ++itr)
+		{
+			if (!ret.empty())
+				ret += ';';
+			ret += **itr;
+		}
+		return ret;
+	}
+public:
+	Profiler(): paths{ PathNode{ 0, 0, 0, {} } } {}
+
+	void enter(size_t ruleId, std::experimental::string_view name, size_t furthestFailure)
+	{
+		if (ruleId >= rules.size())
+			rules.resize(ruleId + 1);
+		auto& stats = rules[ruleId];
+		if (stats.name.empty())
+			stats.name = name.to_string();
+		++stats.calls;
+		++stats.active;
+
+		auto parent = stack.empty() ? 0 : stack.back().node;
+		stack.push_back(Frame{ getChild(parent, ruleId), 0, 0, furthestFailure });
+		// Read the counter last, so that the bookkeeping above is not charged to the rule
+		stack.back().start = detail::readCycleCounter();
+	}
+
+	void exit(bool success, size_t startOffset, size_t endOffset, size_t furthestFailure)
+	{
+		auto now = detail::readCycleCounter();
+		assert(!stack.empty());
+		auto frame = stack.back();
+		stack.pop_back();
+
+		auto& node = paths[frame.node];
+		auto& stats = rules[node.ruleId];
+		auto inclusive = now - frame.start;
+		auto exclusive = inclusive - std::min(inclusive, frame.childTicks);
+
+		--stats.active;
+		if (stats.active == 0)
+			stats.inclusiveTicks += inclusive;
+		stats.exclusiveTicks += exclusive;
+		node.exclusiveTicks += exclusive;
+		if (success)
+		{
+			++stats.successes;
+			stats.bytesConsumed += endOffset - startOffset;
+		}
+		else
+		{
+			++stats.failures;
+			if (furthestFailure > frame.furthestBefore && furthestFailure > startOffset)
+				stats.bytesBacktracked += furthestFailure - startOffset;
+		}
+
+		if (!stack.empty())
+			stack.back().childTicks += inclusive;
+	}
+
+	// The statistics of every named rule that has been called
+	std::vector<RuleStats> getRuleStats() const
+	{
+		auto ret = std::vector<RuleStats>();
+		for (auto const& stats: rules)
+			if (stats.calls != 0)
+				ret.push_back(stats);
+		return ret;
+	}
+
+	// Print one line per rule, the most expensive (by exclusive time) first
+	void printTable(std::ostream& os) const
+	{
+		auto sorted = getRuleStats();
+		std::sort(sorted.begin(), sorted.end(), [] (auto const& a, auto const& b) { return a.exclusiveTicks > b.exclusiveTicks; });
+
+		auto total = uint64_t(0);
+		for (auto const& stats: sorted)
+			total += stats.exclusiveTicks;
+
+		auto flags = os.flags();
+		auto precision = os.precision();
+		os << std::left << std::setw(20) << "rule" << std::right << std::setw(12) << "calls" << std::setw(12) << "success" << std::setw(12) << "failure" << std::setw(14) << "consumed" << std::setw(14) << "backtracked" << std::setw(16) << "incl.ticks" << std::setw(16) << "excl.ticks" << std::setw(8) << "excl%" << "\n";
+		for (auto const& stats: sorted)
+		{
+			auto percent = total == 0 ? 0.0 : 100.0 * stats.exclusiveTicks / total;
+			os << std::left << std::setw(20) << stats.name << std::right << std::setw(12) << stats.calls << std::setw(12) << stats.successes << std::setw(12) << stats.failures << std::setw(14) << stats.bytesConsumed << std::setw(14) << stats.bytesBacktracked << std::setw(16) << stats.inclusiveTicks << std::setw(16) << stats.exclusiveTicks << std::setw(8) << std::fixed << std::setprecision(1) << percent << "\n";
+		}
+		os.flags(flags);
+		os.precision(precision);
+	}
+
+	// Print the exclusive time of every call path in the collapsed stack format ("expr;term;factor 1234" per line) read by flamegraph.pl and speedscope
+	void printCollapsed(std::ostream& os) const
+	{
+		for (auto i = size_t(1); i < paths.size(); ++i)
+			if (paths[i].exclusiveTicks != 0)
+				os << getPathName(i) << ' ' << paths[i].exclusiveTicks << '\n';
+	}
+
+	void clear()
+	{
+		assert(stack.empty() && "Profiler cleared during a parse");
+		rules.clear();
+		paths.resize(1);
+		paths[0].children.clear();
+	}
+};
+
+}
+
+#endif
@@ -0,0 +1,140 @@
+#ifndef PCOMB_TRACER_H
+#define PCOMB_TRACER_H
+
+#include "Context/Profiler.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <experimental/string_view>
+#include <ostream>
+#include <vector>
+
+namespace pcomb
+{
+
+// Tracer records an event each time a rule wrapped with named() is entered or left, while it is attached to a ParseContext with setTracer(). The events go to a ring buffer allocated once at construction, so tracing never allocates, and once the buffer is full the oldest events are overwritten.
+// writeChromeTrace() exports the buffer in the Chrome trace_event JSON format, which chrome://tracing and Perfetto open. Rules are only instrumented when PCOMB_TRACE (or PCOMB_PROFILE) is defined; sampling a fraction of the parses is a matter of attaching the tracer to their contexts only.
+class Tracer
+{
+private:
+	struct Event
+	{
+		uint64_t ticks;
+		std::experimental::string_view name;
+		size_t offset;
+		// 'B' for entering a rule, 'E' for leaving it
+		char phase;
+		bool success;
+	};
+
+	std::vector<Event> events;
+	// The number of events ever recorded. The latest one is at (count - 1) % capacity.
+	uint64_t count;
+
+	// A pair of (tick, wall clock) readings, to convert ticks to microseconds when exporting
+	uint64_t startTicks;
+	std::chrono::steady_clock::time_point startTime;
+
+	void record(char phase, const std::experimental::string_view& name, size_t offset, bool success)
+	{
+		events[count % events.size()] = Event{ detail::readCycleCounter(), name, offset, phase, success };
+		++count;
+	}
+
+	static void writeJSONString(std::ostream& os, const std::experimental::string_view& s)
+	{
+		os << '"';
+		for (auto c: s)
+		{
+			if (c == '"' || c == '\\')
+				os << '\\' << c;
+			else if (static_cast<unsigned char>(c) < 0x20)
+			{
+				char buf[8];
+				std::snprintf(buf, sizeof(buf), "\\u%04x", static_cast<unsigned>(c));
+				os << buf;
+			}
+			else
+				os << c;
+		}
+		os << '"';
+	}
+public:
+	// Names of the events point to the names given to named(), so export while the grammar is still alive
+	Tracer(size_t capacity = 1 << 16): events(capacity), count(0), startTicks(detail::readCycleCounter()), startTime(std::chrono::steady_clock::now())
+	{
+		assert(capacity > 0);
+	}
+
+	void begin(const std::experimental::string_view& name, size_t offset)
+	{
+		record('B', name, offset, false);
+	}
+
+	void end(const std::experimental::string_view& name, size_t offset, bool success)
+	{
+		record('E', name, offset, success);
+	}
+
+	// The number of events held in the buffer, and the number of older ones that were overwritten
+	size_t getNumEvents() const { return static_cast<size_t>(std::min<uint64_t>(count, events.size())); }
+	uint64_t getNumDropped() const { return count - getNumEvents(); }
+
+	void clear() { count = 0; }
+
+	// Write the buffered events as a trace_event JSON object. Ends whose begin was overwritten are dropped, and rules still open at the end of the buffer are closed at the last timestamp, so that the viewer gets balanced slices.
+	void writeChromeTrace(std::ostream& os, int pid = 1, int tid = 1) const
+	{
+		auto elapsedTicks = detail::readCycleCounter() - startTicks;
+		auto elapsedMicros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - startTime).count();
+		auto ticksPerMicro = elapsedTicks > 0 && elapsedMicros > 0 ? elapsedTicks / elapsedMicros : 1.0;
+
+		auto numEvents = getNumEvents();
+		auto first = count - numEvents;
+		auto lastTicks = startTicks;
+		auto open = std::vector<const Event*>();
+		auto separator = "";
+
+		auto writeEvent = [&] (const Event& e, char phase, uint64_t ticks)
+		{
+			os << separator << "{\"name\":";
+			writeJSONString(os, e.name);
+			char ts[32];
+			std::snprintf(ts, sizeof(ts), "%.3f", (ticks - startTicks) / ticksPerMicro);
+			os << ",\"ph\":\"" << phase << "\",\"ts\":" << ts << ",\"pid\":" << pid << ",\"tid\":" << tid << ",\"args\":{\"offset\":" << e.offset;
+			if (phase == 'E')
+				os << ",\"success\":" << (e.success ? "true" : "false");
+			os << "}}";
+			separator = ",\n";
+		};
+
+		os << "{\"traceEvents\":[\n";
+		for (auto i = first; i < count; ++i)
+		{
+			auto const& e = events[i % events.size()];
+			if (e.phase == 'B')
+				open.push_back(&e);
+			else
+			{
+				if (open.empty())
+					continue;
+				open.pop_back();
+			}
+			writeEvent(e, e.phase, e.ticks);
+			lastTicks = e.ticks;
+		}
+		while (!open.empty())
+		{
+			writeEvent(*open.back(), 'E', lastTicks);
+			open.pop_back();
+		}
+		os << "\n],\"displayTimeUnit\":\"ns\"}\n";
+	}
+};
+
+}
+
+#endif
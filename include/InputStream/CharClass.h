@@ -0,0 +1,162 @@
+#ifndef PCOMB_CHAR_CLASS_H
+#define PCOMB_CHAR_CLASS_H
+
+#include <cstdint>
+#include <experimental/string_view>
+#include <memory>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PCOMB_X86_DISPATCH 1
+#include <immintrin.h>
+#endif
+
+namespace pcomb
+{
+
+namespace detail
+{
+
+#if defined(PCOMB_X86_DISPATCH)
+inline bool cpuHasAVX2()
+{
+	static const bool hasAVX2 = __builtin_cpu_supports("avx2");
+	return hasAVX2;
+}
+#endif
+
+}	// end of namespace detail
+
+// CharClass is a set of bytes that can find the end of a run of its members quickly. skip() examines 32 bytes per step with AVX2 when the CPU has it, 16 bytes per step with SSE2 when the class is small (whitespace, for example), and falls back to a table lookup per byte otherwise.
+class CharClass
+{
+private:
+	auto static constexpr MaxCompareMembers = 8u;
+
+	uint64_t bits[4];
+	// The members themselves, for the SSE2 path. Only meaningful if numMembers <= MaxCompareMembers.
+	unsigned char members[MaxCompareMembers];
+	unsigned numMembers;
+	// Nibble tables for the AVX2 path: bit (hi & 7) of lowNibbleRows[hi >> 3][lo] is set iff byte (hi << 4 | lo) is a member
+	alignas(16) unsigned char lowNibbleRows[2][16];
+
+	const char* skipScalar(const char* first, const char* last) const
+	{
+		while (first != last && test(*first))
+			++first;
+		return first;
+	}
+
+#if defined(__SSE2__)
+	const char* skipSSE2(const char* first, const char* last) const
+	{
+		__m128i needles[MaxCompareMembers];
+		for (auto i = 0u; i < numMembers; ++i)
+			needles[i] = _mm_set1_epi8(static_cast<char>(members[i]));
+
+		for (; last - first >= 16; first += 16)
+		{
+			auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+			auto hit = _mm_setzero_si128();
+			for (auto i = 0u; i < numMembers; ++i)
+				hit = _mm_or_si128(hit, _mm_cmpeq_epi8(block, needles[i]));
+			auto mask = ~static_cast<unsigned>(_mm_movemask_epi8(hit)) & 0xFFFFu;
+			if (mask != 0)
+				return first + __builtin_ctz(mask);
+		}
+		return skipScalar(first, last);
+	}
+#endif
+
+#if defined(PCOMB_X86_DISPATCH)
+	const char* skipAVX2(const char* first, const char* last) const __attribute__((target("avx2")))
+	{
+		auto rows = reinterpret_cast<const __m128i*>(lowNibbleRows);
+		auto rowLo = _mm256_broadcastsi128_si256(_mm_load_si128(rows));
+		auto rowHi = _mm256_broadcastsi128_si256(_mm_load_si128(rows + 1));
+		auto bitOfHigh = _mm256_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+		auto nibbleMask = _mm256_set1_epi8(0x0F);
+		auto seven = _mm256_set1_epi8(7);
+
+		for (; last - first >= 32; first += 32)
+		{
+			auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first));
+			auto lo = _mm256_and_si256(block, nibbleMask);
+			auto hi = _mm256_and_si256(_mm256_srli_epi16(block, 4), nibbleMask);
+			auto useHighRow = _mm256_cmpgt_epi8(hi, seven);
+			auto row = _mm256_blendv_epi8(_mm256_shuffle_epi8(rowLo, lo), _mm256_shuffle_epi8(rowHi, lo), useHighRow);
+			auto bit = _mm256_shuffle_epi8(bitOfHigh, hi);
+			auto miss = _mm256_cmpeq_epi8(_mm256_and_si256(row, bit), _mm256_setzero_si256());
+			auto mask = static_cast<unsigned>(_mm256_movemask_epi8(miss));
+			if (mask != 0)
+				return first + __builtin_ctz(mask);
+		}
+		return skipScalar(first, last);
+	}
+#endif
+public:
+	CharClass(): bits{0, 0, 0, 0}, members{}, numMembers(0), lowNibbleRows{} {}
+	CharClass(const std::experimental::string_view& chars): CharClass()
+	{
+		for (auto ch: chars)
+			set(ch);
+	}
+
+	void set(char ch)
+	{
+		auto c = static_cast<unsigned char>(ch);
+		if (test(ch))
+			return;
+
+		bits[c >> 6] |= uint64_t(1) << (c & 63);
+		if (numMembers < MaxCompareMembers)
+			members[numMembers] = c;
+		++numMembers;
+		lowNibbleRows[c >> 7][c & 0x0F] |= static_cast<unsigned char>(1u << ((c >> 4) & 7));
+	}
+
+	bool test(char ch) const
+	{
+		auto c = static_cast<unsigned char>(ch);
+		return (bits[c >> 6] >> (c & 63)) & 1;
+	}
+
+	// Return the first position in [first, last) whose byte is not a member, or last if there is none
+	const char* skip(const char* first, const char* last) const
+	{
+		// Most runs are empty, e.g. no whitespace between two tokens
+		if (first == last || !test(*first))
+			return first;
+
+#if defined(PCOMB_X86_DISPATCH)
+		if (detail::cpuHasAVX2())
+			return skipAVX2(first, last);
+#endif
+#if defined(__SSE2__)
+		if (numMembers <= MaxCompareMembers)
+			return skipSSE2(first, last);
+#endif
+		return skipScalar(first, last);
+	}
+};
+
+namespace detail
+{
+
+// Parsers keep their CharClass behind a shared pointer: it is immutable and takes 80 bytes, and parsers are copied into every combinator they are part of. Those built with the default whitespace all share one instance.
+inline std::shared_ptr<const CharClass> sharedCharClass(const std::experimental::string_view& chars)
+{
+	static const auto defaultWhitespace = std::make_shared<const CharClass>(" \t\n\v\f\r");
+	if (chars == " \t\n\v\f\r")
+		return defaultWhitespace;
+	return std::make_shared<const CharClass>(chars);
+}
+
+}	// end of namespace detail
+
+}
+
+#endif
@@ -0,0 +1,132 @@
+#ifndef PCOMB_CHUNKED_INPUT_H
+#define PCOMB_CHUNKED_INPUT_H
+
+#include "Context/ParseContext.h"
+#include "InputStream/InputStream.h"
+#include "InputStream/RecordInfo.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <experimental/string_view>
+#include <utility>
+#include <vector>
+
+namespace pcomb
+{
+
+// ChunkedInput reads an input of unbounded size (a pipe, a socket replay, a file larger than memory) through a reader callback, one fixed-size chunk at a time.
+// Only the bytes between the commit point and the end of the last chunk are kept. Everything before the commit point is released and its space is reused for the next chunks, so memory stays bounded by the chunk size plus the longest stretch of input that is ever left uncommitted.
+// The reader is called as reader(char* buf, size_t n) and returns the number of bytes it wrote to buf, 0 meaning end of input.
+template <typename Reader>
+class ChunkedInput
+{
+private:
+	Reader reader;
+	std::vector<char> buffer;
+	// buffer[begin, end) is the uncommitted input
+	size_t begin, end;
+	size_t chunkSize;
+	// The offset in the whole input of buffer[0]
+	size_t bufferOffset;
+	bool eof;
+public:
+	ChunkedInput(Reader r, size_t c = 64 << 10): reader(std::move(r)), buffer(2 * c), begin(0), end(0), chunkSize(c), bufferOffset(0), eof(false)
+	{
+		assert(chunkSize > 0);
+	}
+
+	// The uncommitted input. It is invalidated by fill().
+	std::experimental::string_view getWindow() const
+	{
+		return std::experimental::string_view(buffer.data() + begin, end - begin);
+	}
+
+	// The offset in the whole input of the first uncommitted byte
+	size_t getOffset() const { return bufferOffset + begin; }
+
+	bool isEOF() const { return eof; }
+
+	// Read one more chunk. Return false if the reader has reached the end of the input.
+	bool fill()
+	{
+		if (eof)
+			return false;
+
+		if (buffer.size() - end < chunkSize)
+		{
+			// Move the uncommitted bytes to the front to make room, and only grow if that is not enough
+			std::memmove(buffer.data(), buffer.data() + begin, end - begin);
+			bufferOffset += begin;
+			end -= begin;
+			begin = 0;
+			if (buffer.size() - end < chunkSize)
+				buffer.resize(end + chunkSize);
+		}
+
+		auto n = reader(buffer.data() + end, chunkSize);
+		assert(n <= chunkSize);
+		if (n == 0)
+		{
+			eof = true;
+			return false;
+		}
+		end += n;
+		return true;
+	}
+
+	// Release the first n bytes of the window. Nothing before the commit point can be looked at again.
+	void commit(size_t n)
+	{
+		assert(n <= end - begin);
+		begin += n;
+	}
+};
+
+template <typename Reader>
+ChunkedInput<Reader> chunkedInput(Reader&& reader, size_t chunkSize = 64 << 10)
+{
+	return ChunkedInput<Reader>(std::forward<Reader>(reader), chunkSize);
+}
+
+// parseRecords() is the streaming counterpart of many(line(p)). It splits the input into records ending with delimiter, parses each of them with p (without the delimiter), and calls callback(result, info) right away. A record is committed once its callback returns, so memory stays bounded by the chunk size and the longest record.
+// Attributes pointing into the input, like string_views, are only valid inside the callback. If ctx is given, it is attached to every record and reset after it. The last record does not need a delimiter. Return the number of records.
+template <typename ParserA, typename Reader, typename Callback>
+size_t parseRecords(const ParserA& p, ChunkedInput<Reader>& input, Callback&& callback, char delimiter = '\n', ParseContext* ctx = nullptr)
+{
+	auto info = RecordInfo{ input.getOffset(), 0, 1, 1 };
+	// Bytes of the window already known not to contain the delimiter
+	auto scanned = size_t(0);
+
+	while (true)
+	{
+		auto window = input.getWindow();
+		auto found = static_cast<const char*>(std::memchr(window.data() + scanned, delimiter, window.size() - scanned));
+		if (found == nullptr)
+		{
+			scanned = window.size();
+			if (input.fill())
+				continue;
+			// The last record has no delimiter
+			if (window.empty())
+				break;
+			found = window.data() + window.size();
+		}
+
+		auto recordLen = static_cast<size_t>(found - window.data());
+		callback(p.parse(InputStream(window.substr(0, recordLen), ctx)), static_cast<const RecordInfo&>(info));
+		if (ctx != nullptr)
+			ctx->reset();
+
+		auto committed = std::min(recordLen + 1, window.size());
+		detail::advanceRecord(info, window.data(), window.data() + committed);
+		input.commit(committed);
+		scanned = 0;
+	}
+
+	return info.index;
+}
+
+}
+
+#endif
@@ -1,26 +1,29 @@
 #ifndef PCOMB_INPUT_STREAM_H
 #define PCOMB_INPUT_STREAM_H
 
+#include "InputStream/CharClass.h"
+#include "InputStream/LineIndex.h"
+
 #include <cassert>
 #include <experimental/string_view>
 
 namespace pcomb
 {
 
+class ParseContext;
+
+// InputStream is a cursor into the original input buffer. It only remembers where the buffer starts and how much of it is left, so consume() is O(1). Line and column numbers are derived from the byte offset when they are asked for: through the LineIndex of the attached ParseContext, built the first time a position is asked for and searched with a binary search afterwards, or by scanning the buffer from its start if there is no context.
 class InputStream
 {
 private:
-	struct Position
-	{
-		size_t row, col;
-	};
-
+	const char* base;
 	std::experimental::string_view str;
-	Position pos;
+	ParseContext* context;
 
-	InputStream(const std::experimental::string_view& s, const Position& p): str(s), pos(p) {}
+	InputStream(const char* b, const std::experimental::string_view& s, ParseContext* c): base(b), str(s), context(c) {}
 public:
-	InputStream(std::experimental::string_view s): str(s), pos({1, 1}) {}
+	// The optional context is carried along by every stream derived from this one. It must outlive the parse.
+	InputStream(std::experimental::string_view s, ParseContext* c = nullptr): base(s.data()), str(s), context(c) {}
 
 	bool isEOF() const
 	{
@@ -37,28 +40,36 @@ public:
 		return str.data();
 	}
 
+	// The number of bytes consumed since the start of the original buffer
+	size_t getOffset() const
+	{
+		return str.data() - base;
+	}
+
+	ParseContext* getContext() const
+	{
+		return context;
+	}
+
 	InputStream consume(size_t n) const
 	{
 		assert(n <= str.size());
-		auto newPos = pos;
-		for (auto i = 0u; i < n; ++i)
-		{
-			auto ch = str[i];
-			if (ch == '\n')
-			{
-				++newPos.row;
-				newPos.col = 1;
-			}
-			else
-				++newPos.col;
-		}
-		return InputStream(str.substr(n), newPos);
+		return InputStream(base, std::experimental::string_view(str.data() + n, str.size() - n), context);
 	}
 
-	size_t getLineNumber() const { return pos.row; }
-	size_t getColumnNumber() const { return pos.col; }
+	// The members below talk to the context, so they are defined in ParseContext.h, which needs a complete InputStream
+
+	// Consume the maximal run of bytes that belong to cc
+	InputStream skip(const CharClass& cc) const;
+
+	// Both line and column numbers start from 1
+	size_t getLineNumber() const;
+	size_t getColumnNumber() const;
 };
 
 }
 
+// Every user of InputStream gets the definitions of skip(), getLineNumber() and getColumnNumber()
+#include "Context/ParseContext.h"
+
 #endif
@@ -0,0 +1,121 @@
+#ifndef PCOMB_LEXER_H
+#define PCOMB_LEXER_H
+
+#include "InputStream/TokenArray.h"
+#include "Parser/RegexDFA.h"
+
+#include <cstdint>
+#include <experimental/string_view>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace pcomb
+{
+
+// LexerRules lists the token rules of a Lexer. Each rule is a regex in the DFA subset understood by RegexParser; token rules give the kind of the tokens they produce, and skip rules (whitespace, comments) produce none.
+// When several rules match, the longest match wins, and among rules matching the same length the one listed first.
+class LexerRules
+{
+public:
+	struct Rule
+	{
+		std::string pattern;
+		unsigned char kind;
+		bool skip;
+	};
+private:
+	std::vector<Rule> rules;
+	std::vector<std::string> kindNames;
+public:
+	// The name of the kind tells what was expected when tok(kind) fails, e.g. "an identifier"
+	LexerRules& token(unsigned char kind, const std::string& pattern, const std::string& name = std::string())
+	{
+		rules.push_back(Rule{ pattern, kind, false });
+		if (!name.empty())
+		{
+			if (kind >= kindNames.size())
+				kindNames.resize(kind + 1u);
+			kindNames[kind] = name;
+		}
+		return *this;
+	}
+
+	LexerRules& skip(const std::string& pattern)
+	{
+		rules.push_back(Rule{ pattern, 0, true });
+		return *this;
+	}
+
+	const std::vector<Rule>& getRules() const { return rules; }
+	const std::vector<std::string>& getKindNames() const { return kindNames; }
+};
+
+// Lexer compiles all of its rules into a single DFA, which cuts a whole source text into a TokenArray in one pass: every token is found by one walk of the table from the start state, and no byte is looked at again once its token is known.
+// Rules that need backtracking are rejected with std::invalid_argument when the lexer is built.
+class Lexer
+{
+private:
+	using StringView = std::experimental::string_view;
+
+	// The DFA is immutable, so copies of the lexer can share it
+	std::shared_ptr<const detail::RegexDFA> dfa;
+	std::vector<LexerRules::Rule> rules;
+	std::shared_ptr<const std::vector<std::string>> kindNames;
+
+	static std::shared_ptr<const detail::RegexDFA> compileRules(const LexerRules& r)
+	{
+		auto patterns = std::vector<StringView>();
+		for (auto const& rule: r.getRules())
+		{
+			if (!detail::RegexDFA::compile(rule.pattern))
+				throw std::invalid_argument("Lexer rule /" + rule.pattern + "/ cannot be compiled into a DFA");
+			patterns.push_back(rule.pattern);
+		}
+
+		auto ret = detail::RegexDFA::compileAll(patterns);
+		if (!ret)
+			throw std::invalid_argument("Lexer rules cannot be compiled into a DFA");
+		return ret;
+	}
+public:
+	Lexer(const LexerRules& r): dfa(compileRules(r)), rules(r.getRules()), kindNames(std::make_shared<std::vector<std::string>>(r.getKindNames())) {}
+
+	// Tokenize source, which must outlive the returned array. Lexing stops where no rule matches a non-empty prefix of the rest of the source; TokenArray::hasError() tells whether that happened.
+	TokenArray tokenize(StringView source) const
+	{
+		if (source.size() > UINT32_MAX)
+			throw std::length_error("Lexer input larger than 4GB");
+
+		auto ret = TokenArray(source, kindNames);
+		// A guess that avoids most of the reallocations for typical token densities
+		ret.reserve(source.size() / 4);
+
+		auto pos = size_t(0);
+		while (pos < source.size())
+		{
+			auto match = dfa->longestMatchPattern(source.substr(pos));
+			if (match.first <= 0)
+			{
+				ret.setError(pos);
+				break;
+			}
+
+			auto const& rule = rules[match.second];
+			if (!rule.skip)
+				ret.push(rule.kind, pos, static_cast<size_t>(match.first));
+			pos += static_cast<size_t>(match.first);
+		}
+		return ret;
+	}
+};
+
+inline Lexer lexer(const LexerRules& rules)
+{
+	return Lexer(rules);
+}
+
+}
+
+#endif
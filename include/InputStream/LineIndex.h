@@ -0,0 +1,89 @@
+#ifndef PCOMB_LINE_INDEX_H
+#define PCOMB_LINE_INDEX_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <experimental/string_view>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace pcomb
+{
+
+namespace detail
+{
+
+// Count the number of '\n' in [first, last). It is what positions cost when there is no ParseContext to keep a LineIndex in, and how the record drivers move past a record.
+inline size_t countNewlines(const char* first, const char* last)
+{
+	assert(first <= last);
+	auto count = size_t(0);
+
+#if defined(__SSE2__)
+	auto const newline = _mm_set1_epi8('\n');
+	for (; last - first >= 16; first += 16)
+	{
+		auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+		auto mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, newline));
+		count += __builtin_popcount(static_cast<unsigned>(mask));
+	}
+#endif
+
+	for (; first != last; ++first)
+		count += (*first == '\n');
+	return count;
+}
+
+// Return the start of the line that contains last, i.e. the position right after the last '\n' in [first, last), or first if there is none.
+inline const char* findLineStart(const char* first, const char* last)
+{
+	assert(first <= last);
+	while (last != first && last[-1] != '\n')
+		--last;
+	return last;
+}
+
+}	// end of namespace detail
+
+// LineIndex records the start offset of every line in a buffer so that offsets can be mapped to (line, column) pairs with a binary search. Building it costs one linear scan over the buffer; a ParseContext builds it the first time a stream attached to it is asked for a position, and every later query is a binary search.
+class LineIndex
+{
+private:
+	std::vector<size_t> lineStarts;
+public:
+	LineIndex(const std::experimental::string_view& buffer)
+	{
+		lineStarts.push_back(0);
+
+		auto first = buffer.data();
+		auto last = buffer.data() + buffer.size();
+		while (first != last)
+		{
+			auto nl = static_cast<const char*>(std::memchr(first, '\n', last - first));
+			if (nl == nullptr)
+				break;
+			first = nl + 1;
+			lineStarts.push_back(first - buffer.data());
+		}
+	}
+
+	size_t getNumLines() const { return lineStarts.size(); }
+
+	// Both line and column numbers start from 1
+	size_t getLineNumber(size_t offset) const
+	{
+		return std::upper_bound(lineStarts.begin(), lineStarts.end(), offset) - lineStarts.begin();
+	}
+	size_t getColumnNumber(size_t offset) const
+	{
+		return offset - lineStarts[getLineNumber(offset) - 1] + 1;
+	}
+};
+
+}
+
+#endif
@@ -0,0 +1,111 @@
+#ifndef PCOMB_MAPPED_FILE_H
+#define PCOMB_MAPPED_FILE_H
+
+#include "InputStream/InputStream.h"
+
+#include <cerrno>
+#include <experimental/string_view>
+#include <string>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace pcomb
+{
+
+// MappedFile maps a file read-only into memory so that it can be parsed in place, without reading it into a buffer first. string_views returned by parsers such as StringParser and RegexParser point straight into the mapping, so they are only valid as long as the MappedFile is alive.
+// The kernel is told that the mapping will be read sequentially, which is what a parse does most of the time.
+// Errors are reported by throwing std::system_error.
+class MappedFile
+{
+private:
+	const char* data;
+	size_t size;
+
+	static std::system_error makeError(const std::string& what, const std::string& path)
+	{
+		return std::system_error(errno, std::generic_category(), what + " " + path);
+	}
+
+	void unmap()
+	{
+		if (data != nullptr)
+			::munmap(const_cast<char*>(data), size);
+		data = nullptr;
+		size = 0;
+	}
+public:
+	MappedFile(const std::string& path): data(nullptr), size(0)
+	{
+		auto fd = ::open(path.c_str(), O_RDONLY);
+		if (fd < 0)
+			throw makeError("cannot open", path);
+
+		struct stat st;
+		if (::fstat(fd, &st) != 0)
+		{
+			auto err = makeError("cannot stat", path);
+			::close(fd);
+			throw err;
+		}
+
+		size = static_cast<size_t>(st.st_size);
+		// mmap() does not accept empty mappings. An empty file is just an empty input.
+		if (size != 0)
+		{
+			auto addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (addr == MAP_FAILED)
+			{
+				auto err = makeError("cannot map", path);
+				::close(fd);
+				throw err;
+			}
+			data = static_cast<const char*>(addr);
+			::madvise(addr, size, MADV_SEQUENTIAL);
+		}
+		// The mapping stays valid after the descriptor is closed
+		::close(fd);
+	}
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	MappedFile(MappedFile&& other): data(other.data), size(other.size)
+	{
+		other.data = nullptr;
+		other.size = 0;
+	}
+	MappedFile& operator=(MappedFile&& other)
+	{
+		if (this != &other)
+		{
+			unmap();
+			data = other.data;
+			size = other.size;
+			other.data = nullptr;
+			other.size = 0;
+		}
+		return *this;
+	}
+	~MappedFile()
+	{
+		unmap();
+	}
+
+	std::experimental::string_view getStringView() const
+	{
+		return std::experimental::string_view(data, size);
+	}
+
+	size_t getSize() const { return size; }
+
+	InputStream getInputStream(ParseContext* ctx = nullptr) const
+	{
+		return InputStream(getStringView(), ctx);
+	}
+};
+
+}
+
+#endif
@@ -0,0 +1,185 @@
+#ifndef PCOMB_PARALLEL_RECORDS_H
+#define PCOMB_PARALLEL_RECORDS_H
+
+#include "Context/ParseContext.h"
+#include "InputStream/InputStream.h"
+#include "InputStream/RecordInfo.h"
+#include "Parser/ParseResult.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <exception>
+#include <experimental/string_view>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace pcomb
+{
+
+// The result of one record parsed by parallelRecords(). If the record failed to parse, failureOffset and expected tell where it failed and what was expected there, as the ParseContext of a single-threaded parse would; failureOffset is relative to the record like the positions of result.
+template <typename O>
+struct RecordResult
+{
+	RecordInfo info;
+	ParseResult<O> result;
+	size_t failureOffset;
+	std::vector<ExpectedItem> expected;
+
+	// e.g. "one of '(', /[0-9]+/"
+	std::string describeExpected() const { return pcomb::describeExpected(expected); }
+};
+
+namespace detail
+{
+
+// Run task(i, worker) for every i in [0, numTasks) on numThreads threads, where worker in [0, numThreads) identifies the thread running the task. Tasks are handed out one at a time from a shared counter, so a thread that finishes early takes over the remaining work instead of idling. The first exception thrown by a task is rethrown on the calling thread.
+template <typename Task>
+void runParallel(size_t numTasks, size_t numThreads, const Task& task)
+{
+	std::atomic<size_t> next(0);
+	auto error = std::exception_ptr();
+	std::mutex errorMutex;
+
+	auto worker = [&] (size_t id)
+	{
+		for (auto i = next++; i < numTasks; i = next++)
+		{
+			try
+			{
+				task(i, id);
+			}
+			catch (...)
+			{
+				std::lock_guard<std::mutex> lock(errorMutex);
+				if (!error)
+					error = std::current_exception();
+				next = numTasks;
+			}
+		}
+	};
+
+	auto threads = std::vector<std::thread>();
+	for (auto i = size_t(1); i < numThreads; ++i)
+		threads.emplace_back(worker, i);
+	worker(0);
+	for (auto& t: threads)
+		t.join();
+
+	if (error)
+		std::rethrow_exception(error);
+}
+
+// Split input into about numChunks pieces of similar size. Every piece but the last ends right after a delimiter, so no record is cut in two.
+inline std::vector<std::experimental::string_view> splitRecords(const std::experimental::string_view& input, char delimiter, size_t numChunks)
+{
+	auto chunks = std::vector<std::experimental::string_view>();
+	auto first = input.data();
+	auto last = input.data() + input.size();
+	auto target = std::max(input.size() / numChunks, size_t(1));
+
+	while (first != last)
+	{
+		auto cut = last;
+		if (static_cast<size_t>(last - first) > target)
+		{
+			auto nl = static_cast<const char*>(std::memchr(first + target - 1, delimiter, last - (first + target - 1)));
+			if (nl != nullptr)
+				cut = nl + 1;
+		}
+		chunks.emplace_back(first, cut - first);
+		first = cut;
+	}
+	return chunks;
+}
+
+}	// end of namespace detail
+
+// parallelRecords() is a multi-threaded many(line(p)) over an input that is entirely in memory, such as a MappedFile. The input is cut at delimiters into a few chunks per thread, each chunk is parsed record by record on a pool of numThreads threads, and the results come back in input order.
+// Each record is parsed with p (without the delimiter) and a ParseContext owned by the worker thread, which is reset after every record: memo() works within a record, but attributes must not point into the arena (no arenaMany() or arenaRule()). The streams of the returned results have no context. The RecordInfo of each result holds the global offset, index, line and column of its record, and maps positions inside the record to global ones. numThreads == 0 means one per hardware thread.
+template <typename ParserA>
+std::vector<RecordResult<typename ParserA::OutputType>> parallelRecords(const ParserA& p, const std::experimental::string_view& input, char delimiter = '\n', size_t numThreads = 0)
+{
+	using OutputType = typename ParserA::OutputType;
+	using ChunkResults = std::vector<RecordResult<OutputType>>;
+
+	if (numThreads == 0)
+		numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+	// A few chunks per thread keep the threads busy when records are not uniformly expensive
+	auto chunks = detail::splitRecords(input, delimiter, numThreads * 4);
+	numThreads = std::min(numThreads, std::max(chunks.size(), size_t(1)));
+
+	// First pass: parse every chunk, with record positions relative to the start of the chunk
+	auto chunkResults = std::vector<ChunkResults>(chunks.size());
+	auto chunkEnds = std::vector<RecordInfo>(chunks.size());
+	auto contexts = std::unique_ptr<ParseContext[]>(new ParseContext[numThreads]);
+	detail::runParallel(chunks.size(), numThreads, [&] (size_t i, size_t worker)
+	{
+		auto chunk = chunks[i];
+		auto& results = chunkResults[i];
+		auto& ctx = contexts[worker];
+		auto info = RecordInfo{ 0, 0, 1, 1 };
+		auto first = chunk.data();
+		auto last = chunk.data() + chunk.size();
+		while (first != last)
+		{
+			auto nl = static_cast<const char*>(std::memchr(first, delimiter, last - first));
+			auto recordEnd = nl != nullptr ? nl : last;
+			auto next = nl != nullptr ? nl + 1 : last;
+			auto record = std::experimental::string_view(first, recordEnd - first);
+			auto res = p.parse(InputStream(record, &ctx));
+			// The context is reset for the next record and goes away when parallelRecords() returns, so the stream kept in the result is rebuilt without it
+			auto end = InputStream(record).consume(res.getInputStream().getOffset());
+			if (res.success())
+				results.push_back(RecordResult<OutputType>{ info, ParseResult<OutputType>(end, std::move(res).getOutput()), 0, {} });
+			else
+				results.push_back(RecordResult<OutputType>{ info, ParseResult<OutputType>(end), ctx.getFurthestFailureOffset(), ctx.getExpected() });
+			ctx.reset();
+			detail::advanceRecord(info, first, next);
+			first = next;
+		}
+		chunkEnds[i] = info;
+	});
+
+	// Find where each chunk starts in the whole input
+	auto chunkStarts = std::vector<RecordInfo>(chunks.size());
+	auto start = RecordInfo{ 0, 0, 1, 1 };
+	for (auto i = size_t(0); i < chunks.size(); ++i)
+	{
+		chunkStarts[i] = start;
+		auto& end = chunkEnds[i];
+		start.column = end.line == 1 ? start.column + end.column - 1 : end.column;
+		start.line += end.line - 1;
+		start.offset += end.offset;
+		start.index += end.index;
+	}
+
+	// Second pass: turn the positions into global ones
+	detail::runParallel(chunks.size(), numThreads, [&] (size_t i, size_t)
+	{
+		auto& chunkStart = chunkStarts[i];
+		for (auto& r: chunkResults[i])
+		{
+			if (r.info.line == 1)
+				r.info.column += chunkStart.column - 1;
+			r.info.line += chunkStart.line - 1;
+			r.info.offset += chunkStart.offset;
+			r.info.index += chunkStart.index;
+		}
+	});
+
+	auto results = ChunkResults();
+	results.reserve(start.index);
+	for (auto& chunk: chunkResults)
+		std::move(chunk.begin(), chunk.end(), std::back_inserter(results));
+	return results;
+}
+
+}
+
+#endif
@@ -0,0 +1,240 @@
+#ifndef PCOMB_PUSH_INPUT_H
+#define PCOMB_PUSH_INPUT_H
+
+#include "Context/ParseContext.h"
+#include "InputStream/InputStream.h"
+#include "InputStream/RecordInfo.h"
+#include "Parser/ParseResult.h"
+
+#include <cassert>
+#include <cstring>
+#include <experimental/string_view>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace pcomb
+{
+
+// What parsePartial() found out about an input that may be followed by more
+enum class PartialStatus
+{
+	// The result stands whatever comes next
+	Done,
+	// The parse failed before the end of the input, so more input would not help
+	Failed,
+	// The parse looked at the end of the input: more input may change its result, so it has to be run again once there is more
+	NeedMoreInput,
+};
+
+template <typename O>
+struct PartialResult
+{
+	PartialStatus status;
+	ParseResult<O> result;
+};
+
+// Parse input, which may only be the beginning of the whole input if isFinal is false. The parse needs more input if a parser looked at the end of input, as reported to the ParseContext by noteEndReached(): a literal cut short, a run of digits or whitespace that ends with the input, alt() finding nothing but the end, and so on. Parsers written outside this library have to report it too for their results to be trusted.
+// input must have a ParseContext, fresh or reset since its last parse.
+template <typename ParserA>
+PartialResult<typename ParserA::OutputType> parsePartial(const ParserA& p, const InputStream& input, bool isFinal)
+{
+	auto ctx = input.getContext();
+	assert(ctx != nullptr && "parsePartial() needs a ParseContext");
+	assert(!ctx->hasReachedEnd() && "parsePartial() needs a fresh ParseContext");
+
+	auto res = p.parse(input);
+	auto status = PartialStatus::Done;
+	if (!isFinal && ctx->hasReachedEnd())
+		status = PartialStatus::NeedMoreInput;
+	else if (res.hasError())
+		status = PartialStatus::Failed;
+	return PartialResult<typename ParserA::OutputType>{ status, std::move(res) };
+}
+
+// PushInput is the push-style counterpart of parseRecords(): instead of pulling chunks from a reader, the caller feeds fragments as they arrive (from a socket, for example) in whatever sizes they come.
+// It remembers the unfinished record and how much of it has already been scanned for the delimiter, so every byte is scanned once and every record is parsed once, however many fragments it was split into. Records that are not ended by a delimiter are parsed by pushParse() instead.
+// Each complete record is parsed with p (without the delimiter) and handed to callback(result, info) right away. finish() parses the last record, which does not need a delimiter.
+template <typename ParserA, typename Callback>
+class PushInput
+{
+private:
+	ParserA parser;
+	Callback callback;
+	char delimiter;
+	ParseContext* ctx;
+
+	// buffer[begin, end()) is the unfinished record
+	std::vector<char> buffer;
+	size_t begin;
+	// Bytes of the unfinished record already known not to contain the delimiter
+	size_t scanned;
+	// Where the unfinished record starts
+	RecordInfo info;
+	bool finished;
+
+	// Parse the record at begin, which is len bytes long, and move past it and its delimiter
+	void parseRecord(size_t len, size_t delimiterLen)
+	{
+		auto first = buffer.data() + begin;
+		callback(parser.parse(InputStream(std::experimental::string_view(first, len), ctx)), static_cast<const RecordInfo&>(info));
+		if (ctx != nullptr)
+			ctx->reset();
+		detail::advanceRecord(info, first, first + len + delimiterLen);
+		begin += len + delimiterLen;
+	}
+public:
+	PushInput(const ParserA& p, Callback c, char d = '\n', ParseContext* x = nullptr): parser(p), callback(std::move(c)), delimiter(d), ctx(x), begin(0), scanned(0), info{ 0, 0, 1, 1 }, finished(false) {}
+
+	// Append a fragment and parse every record it completes. Return the number of records parsed.
+	size_t feed(const std::experimental::string_view& fragment)
+	{
+		assert(!finished && "feed() after finish()");
+
+		// Drop the parsed records only once they are at least half of the buffer, so that the unfinished record is not moved again on every fragment
+		if (begin > 0 && begin >= buffer.size() - begin)
+		{
+			buffer.erase(buffer.begin(), buffer.begin() + begin);
+			begin = 0;
+		}
+		buffer.insert(buffer.end(), fragment.begin(), fragment.end());
+
+		auto before = info.index;
+		while (true)
+		{
+			auto first = buffer.data() + begin;
+			auto len = buffer.size() - begin;
+			auto found = scanned == len ? nullptr : static_cast<const char*>(std::memchr(first + scanned, delimiter, len - scanned));
+			if (found == nullptr)
+			{
+				scanned = len;
+				break;
+			}
+
+			parseRecord(static_cast<size_t>(found - first), 1);
+			scanned = 0;
+		}
+		return info.index - before;
+	}
+
+	// Signal the end of the input and parse the last record if there is one. Return the number of records parsed.
+	size_t finish()
+	{
+		assert(!finished && "finish() called twice");
+
+		finished = true;
+		if (begin == buffer.size())
+			return 0;
+		parseRecord(buffer.size() - begin, 0);
+		return 1;
+	}
+
+	// Whether an unfinished record is waiting for more input
+	bool needsMoreInput() const { return !finished && begin != buffer.size(); }
+
+	// The number of records parsed so far
+	size_t getRecordCount() const { return info.index; }
+};
+
+template <typename ParserA, typename Callback>
+PushInput<std::remove_reference_t<ParserA>, std::decay_t<Callback>> pushRecords(ParserA&& p, Callback&& c, char delimiter = '\n', ParseContext* ctx = nullptr)
+{
+	return PushInput<std::remove_reference_t<ParserA>, std::decay_t<Callback>>(std::forward<ParserA>(p), std::forward<Callback>(c), delimiter, ctx);
+}
+
+// PushParser parses a sequence of records that only the parser can tell apart, such as length-prefixed frames or JSON values, from fragments fed as they arrive: it is many(p) on an input that comes in pieces.
+// Whenever a fragment comes in, the records it completes are parsed with parsePartial() and handed to callback(result, info) right away. A record that runs into the end of the fragments parsed so far needs more input, and is parsed again from its start once the next fragment comes in; the records before it are never looked at again. finish() tells that no more input is coming, so the last record is parsed for good.
+// A record that fails to parse is handed to the callback and ends the parse, since there is no telling where the next one would start. So does a record that consumes nothing, which would be parsed again forever. The ParseContext is reset after every record, and after every attempt that needs more input; the callback can ask it what was expected where a record failed.
+template <typename ParserA, typename Callback>
+class PushParser
+{
+private:
+	ParserA parser;
+	Callback callback;
+	// The context of the caller, or one of our own
+	std::unique_ptr<ParseContext> ownContext;
+	ParseContext* ctx;
+
+	// buffer[begin, end()) is the unfinished record
+	std::vector<char> buffer;
+	size_t begin;
+	// Where the unfinished record starts
+	RecordInfo info;
+	bool finished, failed;
+
+	// Parse every record that does not need more input. Return the number of records parsed.
+	size_t parseAvailable(bool isFinal)
+	{
+		auto before = info.index;
+		while (!failed && begin != buffer.size())
+		{
+			auto first = buffer.data() + begin;
+			auto len = buffer.size() - begin;
+			auto res = parsePartial(parser, InputStream(std::experimental::string_view(first, len), ctx), isFinal);
+			if (res.status == PartialStatus::NeedMoreInput)
+			{
+				ctx->reset();
+				break;
+			}
+
+			auto consumed = res.status == PartialStatus::Done ? res.result.getInputStream().getOffset() : 0;
+			failed = consumed == 0;
+			callback(std::move(res.result), static_cast<const RecordInfo&>(info));
+			ctx->reset();
+			detail::advanceRecord(info, first, first + consumed);
+			begin += consumed;
+		}
+		return info.index - before;
+	}
+public:
+	PushParser(const ParserA& p, Callback c, ParseContext* x = nullptr): parser(p), callback(std::move(c)), ownContext(x == nullptr ? new ParseContext() : nullptr), ctx(x == nullptr ? ownContext.get() : x), begin(0), info{ 0, 0, 1, 1 }, finished(false), failed(false)
+	{
+		ctx->reset();
+	}
+
+	// Append a fragment and parse every record it completes. Return the number of records parsed.
+	size_t feed(const std::experimental::string_view& fragment)
+	{
+		assert(!finished && "feed() after finish()");
+		if (failed || fragment.empty())
+			return 0;
+
+		// Drop the parsed records only once they are at least half of the buffer, so that the unfinished record is not moved again on every fragment
+		if (begin > 0 && begin >= buffer.size() - begin)
+		{
+			buffer.erase(buffer.begin(), buffer.begin() + begin);
+			begin = 0;
+		}
+		buffer.insert(buffer.end(), fragment.begin(), fragment.end());
+		return parseAvailable(false);
+	}
+
+	// Signal the end of the input and parse the records that were waiting for more. Return the number of records parsed.
+	size_t finish()
+	{
+		assert(!finished && "finish() called twice");
+
+		finished = true;
+		return parseAvailable(true);
+	}
+
+	// Whether an unfinished record is waiting for more input
+	bool needsMoreInput() const { return !finished && !failed && begin != buffer.size(); }
+
+	// Whether a record failed to parse, which ended the parse
+	bool hasFailed() const { return failed; }
+
+	// The number of records handed to the callback so far
+	size_t getRecordCount() const { return info.index; }
+};
+
+template <typename ParserA, typename Callback>
+PushParser<std::remove_reference_t<ParserA>, std::decay_t<Callback>> pushParse(ParserA&& p, Callback&& c, ParseContext* ctx = nullptr)
+{
+	return PushParser<std::remove_reference_t<ParserA>, std::decay_t<Callback>>(std::forward<ParserA>(p), std::forward<Callback>(c), ctx);
+}
+
+}
+
+#endif
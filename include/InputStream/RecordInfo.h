@@ -0,0 +1,54 @@
+#ifndef PCOMB_RECORD_INFO_H
+#define PCOMB_RECORD_INFO_H
+
+#include "InputStream/InputStream.h"
+#include "InputStream/LineIndex.h"
+
+#include <cstddef>
+
+namespace pcomb
+{
+
+// Where a record handed out by the record drivers (parseRecords(), pushRecords(), parallelRecords()) starts in the whole input. Each record is parsed as an input of its own, so positions reported by its InputStream are relative to the record; getLineNumber() and getColumnNumber() turn them into positions in the whole input.
+struct RecordInfo
+{
+	// The offset of the record in the whole input
+	size_t offset;
+	// The number of records before this one
+	size_t index;
+	// The line and column of the first byte of the record, both starting from 1
+	size_t line, column;
+
+	size_t getLineNumber(const InputStream& s) const
+	{
+		return line + s.getLineNumber() - 1;
+	}
+	size_t getColumnNumber(const InputStream& s) const
+	{
+		return s.getLineNumber() == 1 ? column + s.getColumnNumber() - 1 : s.getColumnNumber();
+	}
+};
+
+namespace detail
+{
+
+// Move info past the record [first, last), including its delimiter
+inline void advanceRecord(RecordInfo& info, const char* first, const char* last)
+{
+	auto newlines = countNewlines(first, last);
+	if (newlines == 0)
+		info.column += last - first;
+	else
+	{
+		info.line += newlines;
+		info.column = last - findLineStart(first, last) + 1;
+	}
+	info.offset += last - first;
+	++info.index;
+}
+
+}	// end of namespace detail
+
+}
+
+#endif
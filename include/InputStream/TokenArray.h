@@ -0,0 +1,93 @@
+#ifndef PCOMB_TOKEN_ARRAY_H
+#define PCOMB_TOKEN_ARRAY_H
+
+#include "Context/ParseContext.h"
+#include "InputStream/InputStream.h"
+
+#include <cassert>
+#include <cstdint>
+#include <experimental/string_view>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace pcomb
+{
+
+// TokenArray holds the tokens a Lexer cut a source text into, as a struct of arrays: the kind of every token, and its offset and length in the source.
+// The kinds are stored one byte per token in a contiguous buffer, which getInputStream() turns into an InputStream. Every parser and combinator then runs over the tokens unchanged: ch(kind) and tok(kind) match a token with a single compare, and backtracking only moves a token index. Offsets of such a stream are token indices; getSourceOffset() maps them back to the source.
+class TokenArray
+{
+private:
+	using StringView = std::experimental::string_view;
+
+	StringView source;
+	std::string kinds;
+	std::vector<uint32_t> offsets, lengths;
+	// The names of the token kinds, shared with the Lexer, to tell what was expected when a parser fails
+	std::shared_ptr<const std::vector<std::string>> kindNames;
+	// Where the lexer found no rule to match, if it did
+	bool error;
+	size_t errorOffset;
+public:
+	TokenArray(StringView s, std::shared_ptr<const std::vector<std::string>> names): source(s), kindNames(std::move(names)), error(false), errorOffset(0) {}
+
+	void push(unsigned char kind, size_t offset, size_t length)
+	{
+		kinds.push_back(static_cast<char>(kind));
+		offsets.push_back(static_cast<uint32_t>(offset));
+		lengths.push_back(static_cast<uint32_t>(length));
+	}
+
+	void reserve(size_t n)
+	{
+		kinds.reserve(n);
+		offsets.reserve(n);
+		lengths.reserve(n);
+	}
+
+	void setError(size_t offset)
+	{
+		error = true;
+		errorOffset = offset;
+	}
+
+	// Whether the lexer stopped before the end of the source because no rule matched there, and where
+	bool hasError() const { return error; }
+	size_t getErrorOffset() const { return errorOffset; }
+
+	size_t size() const { return kinds.size(); }
+	StringView getSource() const { return source; }
+
+	unsigned char getKind(size_t i) const { return static_cast<unsigned char>(kinds[i]); }
+	size_t getOffset(size_t i) const { return offsets[i]; }
+	size_t getLength(size_t i) const { return lengths[i]; }
+	StringView getText(size_t i) const { return source.substr(offsets[i], lengths[i]); }
+
+	// The source offset where token i starts, or the end of the source for i == size()
+	size_t getSourceOffset(size_t i) const
+	{
+		assert(i <= size());
+		return i < size() ? offsets[i] : source.size();
+	}
+
+	// The name given to a kind in the lexer rules, or an empty string
+	StringView getKindName(unsigned char kind) const
+	{
+		if (kindNames == nullptr || kind >= kindNames->size())
+			return StringView();
+		return (*kindNames)[kind];
+	}
+
+	// A stream over the token kinds. The context, if any, is told about this array so that tok() can find the text of its tokens. The array must outlive the parse.
+	InputStream getInputStream(ParseContext* ctx = nullptr) const
+	{
+		if (ctx != nullptr)
+			ctx->setTokens(this);
+		return InputStream(StringView(kinds), ctx);
+	}
+};
+
+}
+
+#endif
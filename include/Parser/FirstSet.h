@@ -0,0 +1,61 @@
+#ifndef PCOMB_FIRST_SET_H
+#define PCOMB_FIRST_SET_H
+
+#include <bitset>
+
+namespace pcomb
+{
+
+// FirstSet is a conservative approximation of the input a parser can succeed on: the set of bytes it may start with, plus whether it may succeed without consuming anything (in which case it has to be tried on any input, including EOF).
+// Conservative means the set may be too large but never too small. FirstSet::any() is always a correct answer.
+class FirstSet
+{
+private:
+	std::bitset<256> bytes;
+	bool nullable;
+public:
+	FirstSet(): nullable(false) {}
+
+	static FirstSet any()
+	{
+		auto ret = FirstSet();
+		ret.bytes.set();
+		ret.nullable = true;
+		return ret;
+	}
+	static FirstSet empty()
+	{
+		auto ret = FirstSet();
+		ret.nullable = true;
+		return ret;
+	}
+
+	void add(char ch) { bytes.set(static_cast<unsigned char>(ch)); }
+	void setNullable(bool n) { nullable = n; }
+
+	bool test(char ch) const { return bytes.test(static_cast<unsigned char>(ch)); }
+	bool isNullable() const { return nullable; }
+
+	// The first set of a choice between this and other
+	FirstSet& operator|=(const FirstSet& other)
+	{
+		bytes |= other.bytes;
+		nullable = nullable || other.nullable;
+		return *this;
+	}
+
+	// The first set of this followed by next
+	FirstSet then(const FirstSet& next) const
+	{
+		if (!nullable)
+			return *this;
+		auto ret = *this;
+		ret.bytes |= next.bytes;
+		ret.nullable = next.nullable;
+		return ret;
+	}
+};
+
+}
+
+#endif
@@ -0,0 +1,261 @@
+#ifndef PCOMB_KEYWORD_PARSER_H
+#define PCOMB_KEYWORD_PARSER_H
+
+#include "Context/ParseContext.h"
+#include "Parser/Parser.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <experimental/string_view>
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace pcomb
+{
+
+namespace detail
+{
+
+// KeywordTrie stores a set of strings as a trie whose edges are kept in one flat array, sorted by label within each node. The root has a full 256-entry table since every lookup goes through it.
+class KeywordTrie
+{
+private:
+	using StringView = std::experimental::string_view;
+
+	enum : uint32_t
+	{
+		NoKeyword = UINT32_MAX,
+		NoNode = UINT32_MAX,
+	};
+
+	struct Node
+	{
+		uint32_t keyword;
+		uint32_t edgeBegin, edgeEnd;
+	};
+	struct Edge
+	{
+		unsigned char label;
+		uint32_t target;
+	};
+
+	std::vector<Node> nodes;
+	std::vector<Edge> edges;
+	uint32_t rootTable[256];
+	// The keywords themselves, by index, for the diagnostics of a failed match
+	std::vector<std::string> texts;
+
+	uint32_t findChild(uint32_t node, unsigned char label) const
+	{
+		if (node == 0)
+			return rootTable[label];
+		auto const& n = nodes[node];
+		for (auto i = n.edgeBegin; i < n.edgeEnd; ++i)
+		{
+			if (edges[i].label == label)
+				return edges[i].target;
+			if (edges[i].label > label)
+				break;
+		}
+		return NoNode;
+	}
+public:
+	template <typename Range>
+	KeywordTrie(const Range& keywords)
+	{
+		// Build a pointer-based trie first, then flatten it in breadth-first order
+		struct BuildNode
+		{
+			uint32_t keyword = NoKeyword;
+			std::vector<std::pair<unsigned char, uint32_t>> children;
+		};
+		auto buildNodes = std::vector<BuildNode>(1);
+
+		auto index = uint32_t(0);
+		for (auto const& kw: keywords)
+		{
+			auto cur = uint32_t(0);
+			for (auto ch: StringView(kw))
+			{
+				auto label = static_cast<unsigned char>(ch);
+				auto& children = buildNodes[cur].children;
+				auto itr = std::find_if(children.begin(), children.end(), [label] (auto const& p) { return p.first == label; });
+				if (itr != children.end())
+					cur = itr->second;
+				else
+				{
+					auto next = static_cast<uint32_t>(buildNodes.size());
+					buildNodes[cur].children.emplace_back(label, next);
+					buildNodes.emplace_back();
+					cur = next;
+				}
+			}
+			// When a keyword is listed twice, the first index wins
+			if (buildNodes[cur].keyword == NoKeyword)
+				buildNodes[cur].keyword = index;
+			texts.push_back(StringView(kw).to_string());
+			++index;
+		}
+
+		auto order = std::vector<uint32_t>{ 0 };
+		auto newId = std::vector<uint32_t>(buildNodes.size());
+		for (auto i = 0u; i < order.size(); ++i)
+		{
+			auto& children = buildNodes[order[i]].children;
+			std::sort(children.begin(), children.end());
+			for (auto const& child: children)
+			{
+				newId[child.second] = static_cast<uint32_t>(order.size());
+				order.push_back(child.second);
+			}
+		}
+
+		nodes.reserve(order.size());
+		for (auto old: order)
+		{
+			auto const& bn = buildNodes[old];
+			auto begin = static_cast<uint32_t>(edges.size());
+			for (auto const& child: bn.children)
+				edges.push_back(Edge{ child.first, newId[child.second] });
+			nodes.push_back(Node{ bn.keyword, begin, static_cast<uint32_t>(edges.size()) });
+		}
+
+		std::fill(std::begin(rootTable), std::end(rootTable), NoNode);
+		for (auto i = nodes[0].edgeBegin; i < nodes[0].edgeEnd; ++i)
+			rootTable[edges[i].label] = edges[i].target;
+	}
+
+	// Find the longest keyword that is a prefix of input. Return (length, keyword index), or (0, NoKeyword) if none is. reachedEnd is set if the whole input is a prefix of a longer keyword, i.e. if more input might give a longer match.
+	std::pair<size_t, uint32_t> longestMatch(StringView input, bool& reachedEnd) const
+	{
+		auto best = std::make_pair(size_t(0), nodes[0].keyword);
+		auto cur = uint32_t(0);
+		reachedEnd = false;
+		for (auto i = size_t(0); i < input.size(); ++i)
+		{
+			cur = findChild(cur, static_cast<unsigned char>(input[i]));
+			if (cur == NoNode)
+				return best;
+			if (nodes[cur].keyword != NoKeyword)
+				best = std::make_pair(i + 1, nodes[cur].keyword);
+		}
+		reachedEnd = nodes[cur].edgeBegin != nodes[cur].edgeEnd;
+		return best;
+	}
+	std::pair<size_t, uint32_t> longestMatch(StringView input) const
+	{
+		auto reachedEnd = false;
+		return longestMatch(input, reachedEnd);
+	}
+
+	static bool isMatch(const std::pair<size_t, uint32_t>& m) { return m.second != NoKeyword; }
+
+	// Call f with each keyword that starts with the longest prefix of input found in the trie, i.e. the keywords the input was closest to, in the order they were given
+	template <typename F>
+	void forEachCandidate(StringView input, F f) const
+	{
+		auto cur = uint32_t(0);
+		for (auto ch: input)
+		{
+			auto next = findChild(cur, static_cast<unsigned char>(ch));
+			if (next == NoNode)
+				break;
+			cur = next;
+		}
+
+		auto found = std::vector<uint32_t>();
+		auto stack = std::vector<uint32_t>{ cur };
+		while (!stack.empty())
+		{
+			auto const& n = nodes[stack.back()];
+			stack.pop_back();
+			if (n.keyword != NoKeyword)
+				found.push_back(n.keyword);
+			for (auto i = n.edgeBegin; i < n.edgeEnd; ++i)
+				stack.push_back(edges[i].target);
+		}
+		std::sort(found.begin(), found.end());
+		for (auto i: found)
+			f(StringView(texts[i]));
+	}
+
+	FirstSet getFirstSet() const
+	{
+		auto ret = FirstSet();
+		ret.setNullable(nodes[0].keyword != NoKeyword);
+		for (auto c = 0u; c < 256; ++c)
+			if (rootTable[c] != NoNode)
+				ret.add(static_cast<char>(c));
+		return ret;
+	}
+};
+
+}	// end of namespace detail
+
+// KeywordParser matches the longest of a set of strings at the start of the input. It returns the matched string together with its index in the set.
+// It does the same job as alt(str("a"), str("b"), ...) in one pass over the input, however many strings there are. On failure it reports the strings the input was closest to as expected, as that alt() would.
+class KeywordParser: public Parser<std::pair<std::experimental::string_view, size_t>>
+{
+private:
+	using StringView = std::experimental::string_view;
+	// The trie is immutable, so copies of the parser can share it
+	std::shared_ptr<const detail::KeywordTrie> trie;
+
+	// Only worth the trie walk if the failure is going to be recorded
+	void noteCandidates(const InputStream& input) const
+	{
+		auto ctx = input.getContext();
+		if (ctx == nullptr || !ctx->isAtFurthestFailure(input.getOffset()))
+			return;
+		trie->forEachCandidate(input.getInputStringView(), [ctx, &input] (StringView kw)
+		{
+			ctx->noteFailure(input.getOffset(), ExpectedItem::literal(kw));
+		});
+	}
+public:
+	using OutputType = std::pair<StringView, size_t>;
+	using ResultType = typename Parser<OutputType>::ResultType;
+
+	template <typename Range>
+	KeywordParser(const Range& keywords): trie(std::make_shared<detail::KeywordTrie>(keywords)) {}
+
+	ResultType parse(const InputStream& input) const override final
+	{
+		auto ret = ResultType(input);
+
+		auto inputView = input.getInputStringView();
+		auto reachedEnd = false;
+		auto match = trie->longestMatch(inputView, reachedEnd);
+		if (reachedEnd)
+			noteEndReached(input);
+		if (detail::KeywordTrie::isMatch(match))
+			ret = ResultType(input.consume(match.first), OutputType(inputView.substr(0, match.first), match.second));
+		else
+			noteCandidates(input);
+
+		return ret;
+	}
+
+	FirstSet getFirstSet() const override final
+	{
+		return trie->getFirstSet();
+	}
+};
+
+inline KeywordParser oneOf(std::initializer_list<std::experimental::string_view> keywords)
+{
+	return KeywordParser(keywords);
+}
+
+template <typename Range>
+KeywordParser oneOf(const Range& keywords)
+{
+	return KeywordParser(keywords);
+}
+
+}
+
+#endif
@@ -0,0 +1,337 @@
+#ifndef PCOMB_NUMBER_PARSER_H
+#define PCOMB_NUMBER_PARSER_H
+
+#include "Context/ParseContext.h"
+#include "Parser/Parser.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <type_traits>
+
+namespace pcomb
+{
+
+namespace detail
+{
+
+inline bool isDigit(char c)
+{
+	return static_cast<unsigned char>(c - '0') < 10;
+}
+
+// value = value * mul + add, unless that overflows. Return whether it did.
+inline bool mulAddOverflow(uint64_t& value, uint64_t mul, uint64_t add)
+{
+#if defined(__GNUC__)
+	uint64_t ret;
+	if (__builtin_mul_overflow(value, mul, &ret) || __builtin_add_overflow(ret, add, &ret))
+		return true;
+	value = ret;
+	return false;
+#else
+	if (value > (UINT64_MAX - add) / mul)
+		return true;
+	value = value * mul + add;
+	return false;
+#endif
+}
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define PCOMB_SWAR_DIGITS 1
+
+// Whether the 8 bytes loaded in v are all ASCII digits
+inline bool allDigits8(uint64_t v)
+{
+	return ((v & 0xF0F0F0F0F0F0F0F0ull) | (((v + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) >> 4)) == 0x3333333333333333ull;
+}
+
+// The value of the 8 digits loaded in v, with three multiplications instead of eight
+inline uint64_t parse8Digits(uint64_t v)
+{
+	v -= 0x3030303030303030ull;
+	v = (v * 10) + (v >> 8);
+	return (((v & 0x000000FF000000FFull) * (100 + (1000000ull << 32))) + (((v >> 16) & 0x000000FF000000FFull) * (1 + (10000ull << 32)))) >> 32;
+}
+#endif
+
+// Scan the run of digits starting at p, and append them to value. Runs of 8 digits are converted at once. overflow is set if value no longer fits, and the rest of the run is only skipped then.
+inline const char* scanDigits(const char* p, const char* e, uint64_t& value, bool& overflow)
+{
+#ifdef PCOMB_SWAR_DIGITS
+	while (e - p >= 8)
+	{
+		uint64_t v;
+		std::memcpy(&v, p, sizeof(v));
+		if (!allDigits8(v))
+			break;
+		if (!overflow)
+			overflow = mulAddOverflow(value, 100000000, parse8Digits(v));
+		p += 8;
+	}
+#endif
+	for (; p != e && isDigit(*p); ++p)
+		if (!overflow)
+			overflow = mulAddOverflow(value, 10, static_cast<uint64_t>(*p - '0'));
+	return p;
+}
+
+// Whether more input could extend the decimal number that ends at p: digits, a fraction after a trailing '.', or an exponent after a trailing 'e' and its sign may still come
+inline bool numberMayContinue(const char* p, const char* e)
+{
+	if (p == e)
+		return true;
+	if (*p == '.')
+		return p + 1 == e;
+	if (*p != 'e' && *p != 'E')
+		return false;
+	++p;
+	if (p != e && (*p == '-' || *p == '+'))
+		++p;
+	return p == e;
+}
+
+// The powers of ten that a double holds exactly
+inline double exactPowerOfTen(unsigned n)
+{
+	static const double powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+	return powers[n];
+}
+
+template <typename T>
+struct FloatTraits;
+
+template <>
+struct FloatTraits<float>
+{
+	enum { MaxExactPower = 10 };
+	static float convert(const char* s, char** end) { return std::strtof(s, end); }
+};
+
+template <>
+struct FloatTraits<double>
+{
+	enum { MaxExactPower = 22 };
+	static double convert(const char* s, char** end) { return std::strtod(s, end); }
+};
+
+// Describes the range of T for the failure of a number that does not fit, e.g. "an integer in [0, 255]"
+template <typename T>
+const std::string& describeIntegerRange()
+{
+	static const std::string text = "an integer in [" + std::to_string(std::numeric_limits<T>::min()) + ", " + std::to_string(std::numeric_limits<T>::max()) + "]";
+	return text;
+}
+
+}	// end of namespace detail
+
+// IntegerParser matches a decimal integer, with a leading '+' or '-' if T is signed, and returns its value as its attribute. Digits are scanned and converted in the same pass straight from the input, eight at a time where the input allows.
+// A number that does not fit in T fails to parse, and is reported as expecting an integer in the range of T.
+template <typename T>
+class IntegerParser: public Parser<T>
+{
+private:
+	static_assert(std::is_integral<T>::value && !std::is_same<T, bool>::value && sizeof(T) <= sizeof(uint64_t), "IntegerParser only accepts integer types of up to 64 bits");
+public:
+	using OutputType = T;
+	using ResultType = typename Parser<T>::ResultType;
+
+	ResultType parse(const InputStream& input) const override final
+	{
+		auto inputView = input.getInputStringView();
+		auto p = inputView.data();
+		auto e = p + inputView.size();
+
+		auto negative = false;
+		if (std::is_signed<T>::value && p != e && (*p == '-' || *p == '+'))
+		{
+			negative = *p == '-';
+			++p;
+		}
+		if (p == e || !detail::isDigit(*p))
+		{
+			if (p == e)
+				noteEndReached(input);
+			noteFailure(input, ExpectedItem::label("an integer"));
+			return ResultType(input);
+		}
+
+		auto magnitude = uint64_t(0);
+		auto overflow = false;
+		p = detail::scanDigits(p, e, magnitude, overflow);
+		if (p == e)
+			noteEndReached(input);
+
+		// The magnitude of the most negative value is one more than that of the most positive one
+		auto limit = static_cast<uint64_t>(std::numeric_limits<T>::max()) + (negative ? 1 : 0);
+		if (overflow || magnitude > limit)
+		{
+			noteFailure(input, ExpectedItem::label(detail::describeIntegerRange<T>()));
+			return ResultType(input);
+		}
+
+		// Negate in the unsigned domain, where the most negative value does not overflow
+		auto value = negative ? static_cast<T>(0 - magnitude) : static_cast<T>(magnitude);
+		return ResultType(input.consume(p - inputView.data()), value);
+	}
+
+	FirstSet getFirstSet() const override final
+	{
+		auto ret = FirstSet();
+		for (auto c = '0'; c <= '9'; ++c)
+			ret.add(c);
+		if (std::is_signed<T>::value)
+		{
+			ret.add('+');
+			ret.add('-');
+		}
+		return ret;
+	}
+};
+
+// FloatingParser matches a decimal floating point number, i.e. [+-]?[0-9]+(\.[0-9]+)?([eE][+-]?[0-9]+)?, and returns its value as its attribute.
+// Numbers with up to 19 significant digits and a small exponent, which covers most of the numbers found in CSV files or metrics, are converted exactly in the same pass as the scan. The others are handed to strtod(), which expects the "C" locale. A number too large for T fails to parse.
+template <typename T>
+class FloatingParser: public Parser<T>
+{
+private:
+	static_assert(std::is_same<T, float>::value || std::is_same<T, double>::value, "FloatingParser only accepts float or double");
+
+	using Traits = detail::FloatTraits<T>;
+public:
+	using OutputType = T;
+	using ResultType = typename Parser<T>::ResultType;
+private:
+	static ResultType fail(const InputStream& input, const char* what)
+	{
+		noteFailure(input, ExpectedItem::label(what));
+		return ResultType(input);
+	}
+public:
+
+	ResultType parse(const InputStream& input) const override final
+	{
+		auto inputView = input.getInputStringView();
+		auto start = inputView.data();
+		auto p = start;
+		auto e = p + inputView.size();
+
+		auto negative = false;
+		if (p != e && (*p == '-' || *p == '+'))
+		{
+			negative = *p == '-';
+			++p;
+		}
+		if (p == e || !detail::isDigit(*p))
+		{
+			if (p == e)
+				noteEndReached(input);
+			return fail(input, "a number");
+		}
+
+		// The digits before and after the point form one mantissa, and the point shifts the exponent
+		auto mantissa = uint64_t(0);
+		auto overflow = false;
+		p = detail::scanDigits(p, e, mantissa, overflow);
+		auto exponent = long(0);
+		if (e - p >= 2 && *p == '.' && detail::isDigit(p[1]))
+		{
+			auto fraction = p + 1;
+			p = detail::scanDigits(fraction, e, mantissa, overflow);
+			exponent -= p - fraction;
+		}
+		if (p != e && (*p == 'e' || *p == 'E'))
+		{
+			auto q = p + 1;
+			auto negativeExponent = false;
+			if (q != e && (*q == '-' || *q == '+'))
+			{
+				negativeExponent = *q == '-';
+				++q;
+			}
+			// Without digits, the 'e' is not part of the number
+			if (q != e && detail::isDigit(*q))
+			{
+				auto explicitExponent = uint64_t(0);
+				auto exponentOverflow = false;
+				p = detail::scanDigits(q, e, explicitExponent, exponentOverflow);
+				// Any exponent this large gives infinity or zero anyway
+				if (exponentOverflow || explicitExponent > 100000)
+					explicitExponent = 100000;
+				exponent += negativeExponent ? -static_cast<long>(explicitExponent) : static_cast<long>(explicitExponent);
+			}
+		}
+
+		if (detail::numberMayContinue(p, e))
+			noteEndReached(input);
+
+		auto len = static_cast<size_t>(p - start);
+		// Clinger's fast path: both the mantissa and the power of ten are exact, so a single rounding gives the correctly rounded result
+		if (!overflow && mantissa <= (uint64_t(1) << std::numeric_limits<T>::digits) && exponent >= -Traits::MaxExactPower && exponent <= Traits::MaxExactPower)
+		{
+			auto value = static_cast<T>(mantissa);
+			if (exponent < 0)
+				value /= static_cast<T>(detail::exactPowerOfTen(-exponent));
+			else
+				value *= static_cast<T>(detail::exactPowerOfTen(exponent));
+			return ResultType(input.consume(len), negative ? -value : value);
+		}
+
+		// strtod() needs a terminated copy. Numbers almost always fit in the buffer on the stack.
+		char buffer[64];
+		auto heapCopy = std::string();
+		auto text = buffer;
+		if (len < sizeof(buffer))
+		{
+			std::memcpy(buffer, start, len);
+			buffer[len] = '\0';
+		}
+		else
+		{
+			heapCopy.assign(start, len);
+			text = &heapCopy[0];
+		}
+		errno = 0;
+		auto value = Traits::convert(text, nullptr);
+		if (errno == ERANGE && (value == std::numeric_limits<T>::infinity() || value == -std::numeric_limits<T>::infinity()))
+			return fail(input, "a number in the range of the floating point type");
+		return ResultType(input.consume(len), value);
+	}
+
+	FirstSet getFirstSet() const override final
+	{
+		auto ret = FirstSet();
+		for (auto c = '0'; c <= '9'; ++c)
+			ret.add(c);
+		ret.add('+');
+		ret.add('-');
+		return ret;
+	}
+};
+
+template <typename T = long>
+IntegerParser<T> integer()
+{
+	static_assert(std::is_signed<T>::value, "integer() only accepts signed types, use uinteger() for unsigned ones");
+	return IntegerParser<T>();
+}
+
+template <typename T = unsigned long>
+IntegerParser<T> uinteger()
+{
+	static_assert(std::is_unsigned<T>::value, "uinteger() only accepts unsigned types, use integer() for signed ones");
+	return IntegerParser<T>();
+}
+
+template <typename T = double>
+FloatingParser<T> floating()
+{
+	return FloatingParser<T>();
+}
+
+}
+
+#endif
@@ -54,6 +54,12 @@ public:
 	}
 };
 
+// Ignored is the attribute of a parser whose result nobody cares about. SeqParser leaves such attributes out of its tuple.
+struct Ignored {};
+
+// RecognizeResult is what Parser::recognize() returns: whether the parse succeeded and where it stopped, without any attribute
+using RecognizeResult = ParseResult<Ignored>;
+
 }
 
 #endif
@@ -2,6 +2,7 @@
 #define PCOMB_PARSER_H
 
 #include "InputStream/InputStream.h"
+#include "Parser/FirstSet.h"
 #include "Parser/ParseResult.h"
 
 #include <type_traits>
@@ -19,6 +20,23 @@ public:
 	virtual ~Parser() {}
 
 	virtual ResultType parse(const InputStream& input) const = 0;
+
+	// Recognizer mode: run the parser only to find out whether it succeeds and where it stops. Combinators override this to recognize their sub-parsers in turn, so no attribute gets built, no converter gets called and no container gets filled along the way.
+	// The default simply runs parse() and drops the attribute, which is all a parser with a cheap attribute needs.
+	virtual RecognizeResult recognize(const InputStream& input) const
+	{
+		auto result = parse(input);
+		auto ret = RecognizeResult(result.getInputStream());
+		if (result.success())
+			ret.setOutput(Ignored());
+		return ret;
+	}
+
+	// Return a conservative approximation of what the parser can start with. Parsers that cannot tell keep the default, which says "anything".
+	virtual FirstSet getFirstSet() const
+	{
+		return FirstSet::any();
+	}
 };
 
 }
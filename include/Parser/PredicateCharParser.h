@@ -1,11 +1,43 @@
 #ifndef PCOMB_PREDICATE_CHAR_PARSER_H
 #define PCOMB_PREDICATE_CHAR_PARSER_H
 
+#include "Context/ParseContext.h"
 #include "Parser/Parser.h"
 
 namespace pcomb
 {
 
+namespace detail
+{
+
+// What a PredicateCharParser reports as expected when it fails. Predicates that can describe themselves provide getExpected().
+template <typename Pred>
+auto expectedOfPredicate(const Pred& pred, int) -> decltype(pred.getExpected())
+{
+	return pred.getExpected();
+}
+template <typename Pred>
+ExpectedItem expectedOfPredicate(const Pred&, long)
+{
+	return ExpectedItem::label("a character");
+}
+
+// The first set of a PredicateCharParser. Predicates that know which chars they accept provide getFirstSet(); any other predicate may be called on the first char only, so it is taken to accept every byte.
+template <typename Pred>
+auto firstSetOfPredicate(const Pred& pred, int) -> decltype(pred.getFirstSet())
+{
+	return pred.getFirstSet();
+}
+template <typename Pred>
+FirstSet firstSetOfPredicate(const Pred&, long)
+{
+	auto ret = FirstSet::any();
+	ret.setNullable(false);
+	return ret;
+}
+
+}	// end of namespace detail
+
 // PredicateCharParser matches a char that satisfies a predicate and returns that char as its attribute
 template <typename Pred>
 class PredicateCharParser: public Parser<char>
@@ -19,6 +51,8 @@ public:
 	PredicateCharParser(const Pred& p): pred(p) {}
 	PredicateCharParser(Pred&& p): pred(std::move(p)) {}
 
+	const Pred& getPredicate() const { return pred; }
+
 	ResultType parse(const InputStream& input) const override final
 	{
 		auto ret = ResultType(input);
@@ -27,11 +61,19 @@ public:
 		{
 			auto firstChar = input.getRawBuffer()[0];
 			if (pred(firstChar))
-				ret = ResultType(input.consume(1), firstChar);
+				return ResultType(input.consume(1), firstChar);
 		}
+		else
+			noteEndReached(input);
+		noteFailure(input, detail::expectedOfPredicate(pred, 0));
 		
 		return ret;
 	}
+
+	FirstSet getFirstSet() const override final
+	{
+		return detail::firstSetOfPredicate(pred, 0);
+	}
 };
 
 namespace detail
@@ -48,6 +90,18 @@ public:
 	{
 		return c == ch;
 	}
+
+	ExpectedItem getExpected() const
+	{
+		return ExpectedItem::character(ch);
+	}
+
+	FirstSet getFirstSet() const
+	{
+		auto ret = FirstSet();
+		ret.add(ch);
+		return ret;
+	}
 };
 
 class CharRangePredicate
@@ -61,6 +115,19 @@ public:
 	{
 		return c >= lo && c <= hi;
 	}
+
+	ExpectedItem getExpected() const
+	{
+		return ExpectedItem::charRange(lo, hi);
+	}
+
+	FirstSet getFirstSet() const
+	{
+		auto ret = FirstSet();
+		for (auto c = static_cast<int>(lo); c <= static_cast<int>(hi); ++c)
+			ret.add(static_cast<char>(c));
+		return ret;
+	}
 };
 
 }	// end of namespace detail
@@ -70,9 +137,9 @@ inline PredicateCharParser<detail::CharEqPredicate> ch(char c)
 	return PredicateCharParser<detail::CharEqPredicate>(detail::CharEqPredicate(c));
 }
 
-// The enable_if here is to avoid instantiating this template when CustomPredicate is char
+// The enable_if here is to avoid instantiating this template when CustomPredicate is char, or anything else that converts to a char such as a token kind enum
 template <typename CustomPredicate>
-std::enable_if_t<!std::is_same<CustomPredicate, char>::value, PredicateCharParser<CustomPredicate>> ch(CustomPredicate p)
+std::enable_if_t<!std::is_convertible<CustomPredicate, char>::value, PredicateCharParser<CustomPredicate>> ch(CustomPredicate p)
 {
 	return PredicateCharParser<CustomPredicate>(std::move(p));
 }
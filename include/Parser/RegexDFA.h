@@ -0,0 +1,742 @@
+#ifndef PCOMB_REGEX_DFA_H
+#define PCOMB_REGEX_DFA_H
+
+#include "Parser/FirstSet.h"
+
+#include <algorithm>
+#include <bitset>
+#include <cstdint>
+#include <experimental/string_view>
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace pcomb
+{
+
+namespace detail
+{
+
+// RegexDFA is a byte-level deterministic automaton compiled from the regular subset of the ECMAScript regex syntax: literals, escapes, '.', character classes, groups, alternation and greedy quantifiers (including counted ones).
+// It only answers one question: what is the longest prefix of the input that matches the pattern? That is done in a single forward pass with one table lookup per byte, no recursion and no backtracking.
+// Note that the answer is the POSIX-style longest match. For patterns such as "a|ab" ECMAScript would prefer the first alternative that matches, but for the usual token patterns the two coincide.
+class RegexDFA
+{
+private:
+	using StringView = std::experimental::string_view;
+	using CharSet = std::bitset<256>;
+
+	// Parsed regex AST
+	struct Node
+	{
+		enum Kind { Set, Concat, Alt, Repeat };
+
+		Kind kind;
+		size_t set;
+		int minRep, maxRep;
+		std::vector<std::unique_ptr<Node>> children;
+
+		Node(Kind k): kind(k), set(0), minRep(0), maxRep(0) {}
+	};
+	using NodePtr = std::unique_ptr<Node>;
+
+	// Recursive descent parser for the regex syntax. It gives up (by setting unsupported) on anything that cannot be expressed with a DFA or that it does not understand, so that the caller can fall back to std::regex.
+	class RegexSyntaxParser
+	{
+	private:
+		StringView pattern;
+		size_t pos;
+		std::vector<CharSet>& sets;
+	public:
+		bool unsupported;
+
+		RegexSyntaxParser(StringView p, std::vector<CharSet>& s): pattern(p), pos(0), sets(s), unsupported(false) {}
+
+		bool atEnd() const { return pos >= pattern.size(); }
+		char peek() const { return pattern[pos]; }
+
+		NodePtr makeSet(const CharSet& cs)
+		{
+			auto node = std::make_unique<Node>(Node::Set);
+			node->set = sets.size();
+			sets.push_back(cs);
+			return node;
+		}
+
+		static CharSet digitSet()
+		{
+			auto cs = CharSet();
+			for (auto c = '0'; c <= '9'; ++c)
+				cs.set(static_cast<unsigned char>(c));
+			return cs;
+		}
+		static CharSet wordSet()
+		{
+			auto cs = digitSet();
+			for (auto c = 'a'; c <= 'z'; ++c)
+			{
+				cs.set(static_cast<unsigned char>(c));
+				cs.set(static_cast<unsigned char>(c - 'a' + 'A'));
+			}
+			cs.set('_');
+			return cs;
+		}
+		static CharSet spaceSet()
+		{
+			auto cs = CharSet();
+			for (auto c: StringView(" \t\n\v\f\r"))
+				cs.set(static_cast<unsigned char>(c));
+			return cs;
+		}
+
+		static char firstChar(const CharSet& cs)
+		{
+			for (auto c = 0u; c < cs.size(); ++c)
+				if (cs.test(c))
+					return static_cast<char>(c);
+			return '\0';
+		}
+
+		static int hexValue(char c)
+		{
+			if (c >= '0' && c <= '9')
+				return c - '0';
+			if (c >= 'a' && c <= 'f')
+				return c - 'a' + 10;
+			if (c >= 'A' && c <= 'F')
+				return c - 'A' + 10;
+			return -1;
+		}
+
+		// Parse the escape sequence after a backslash. Returns the set of bytes it stands for, and whether it is a single character (which is what class ranges need).
+		CharSet parseEscape(bool inClass, bool& isSingle)
+		{
+			auto cs = CharSet();
+			isSingle = false;
+			if (atEnd())
+			{
+				unsupported = true;
+				return cs;
+			}
+
+			auto c = pattern[pos++];
+			switch (c)
+			{
+				case 'd': return digitSet();
+				case 'D': return ~digitSet();
+				case 'w': return wordSet();
+				case 'W': return ~wordSet();
+				case 's': return spaceSet();
+				case 'S': return ~spaceSet();
+				case 't': c = '\t'; break;
+				case 'n': c = '\n'; break;
+				case 'r': c = '\r'; break;
+				case 'v': c = '\v'; break;
+				case 'f': c = '\f'; break;
+				case '0': c = '\0'; break;
+				case 'b':
+					// \b is a word boundary outside a class and a backspace inside
+					if (!inClass)
+						unsupported = true;
+					c = '\b';
+					break;
+				case 'x':
+				{
+					if (pos + 2 > pattern.size() || hexValue(pattern[pos]) < 0 || hexValue(pattern[pos + 1]) < 0)
+					{
+						unsupported = true;
+						return cs;
+					}
+					c = static_cast<char>(hexValue(pattern[pos]) * 16 + hexValue(pattern[pos + 1]));
+					pos += 2;
+					break;
+				}
+				default:
+					// Back references, \B, \c and \u are left to std::regex. So is any other letter or digit, whose meaning we are not sure of.
+					if ((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'))
+						unsupported = true;
+					break;
+			}
+			isSingle = true;
+			cs.set(static_cast<unsigned char>(c));
+			return cs;
+		}
+
+		NodePtr parseClass()
+		{
+			// The leading '[' has been consumed
+			auto cs = CharSet();
+			auto negate = false;
+			if (!atEnd() && peek() == '^')
+			{
+				negate = true;
+				++pos;
+			}
+			if (!atEnd() && peek() == ']')
+			{
+				// "[]" and "[^]" have dialect-specific meanings
+				unsupported = true;
+				return nullptr;
+			}
+
+			while (!atEnd() && peek() != ']')
+			{
+				auto isSingle = true;
+				auto lo = CharSet();
+				auto loChar = pattern[pos++];
+				if (loChar == '\\')
+				{
+					lo = parseEscape(true, isSingle);
+					if (unsupported)
+						return nullptr;
+					if (isSingle)
+						loChar = firstChar(lo);
+				}
+				else if (loChar == '[')
+				{
+					// POSIX classes like [:alpha:] are not handled here
+					unsupported = true;
+					return nullptr;
+				}
+				else
+					lo.set(static_cast<unsigned char>(loChar));
+
+				if (pos + 1 < pattern.size() && peek() == '-' && pattern[pos + 1] != ']')
+				{
+					++pos;
+					auto hiChar = pattern[pos++];
+					if (hiChar == '\\')
+					{
+						auto hiSingle = true;
+						auto hi = parseEscape(true, hiSingle);
+						if (unsupported)
+							return nullptr;
+						if (!hiSingle)
+						{
+							unsupported = true;
+							return nullptr;
+						}
+						hiChar = firstChar(hi);
+					}
+					if (!isSingle || static_cast<unsigned char>(loChar) > static_cast<unsigned char>(hiChar))
+					{
+						unsupported = true;
+						return nullptr;
+					}
+					for (auto c = static_cast<unsigned>(static_cast<unsigned char>(loChar)); c <= static_cast<unsigned char>(hiChar); ++c)
+						cs.set(c);
+				}
+				else
+					cs |= lo;
+			}
+
+			if (atEnd())
+			{
+				unsupported = true;
+				return nullptr;
+			}
+			++pos;
+
+			return makeSet(negate ? ~cs : cs);
+		}
+
+		NodePtr parseAtom()
+		{
+			auto c = pattern[pos++];
+			switch (c)
+			{
+				case '.':
+				{
+					auto cs = CharSet();
+					cs.set();
+					cs.reset('\n');
+					cs.reset('\r');
+					return makeSet(cs);
+				}
+				case '[':
+					return parseClass();
+				case '(':
+				{
+					if (!atEnd() && peek() == '?')
+					{
+						// Only non-capturing groups are supported; lookaheads need backtracking
+						if (pos + 1 < pattern.size() && pattern[pos + 1] == ':')
+							pos += 2;
+						else
+						{
+							unsupported = true;
+							return nullptr;
+						}
+					}
+					auto node = parseAlt();
+					if (unsupported || atEnd() || peek() != ')')
+					{
+						unsupported = true;
+						return nullptr;
+					}
+					++pos;
+					return node;
+				}
+				case '\\':
+				{
+					auto isSingle = true;
+					auto cs = parseEscape(false, isSingle);
+					if (unsupported)
+						return nullptr;
+					return makeSet(cs);
+				}
+				case '^':
+				case '$':
+				case ']':
+				case '}':
+				case '{':
+				case '*':
+				case '+':
+				case '?':
+				case ')':
+					unsupported = true;
+					return nullptr;
+				default:
+				{
+					auto cs = CharSet();
+					cs.set(static_cast<unsigned char>(c));
+					return makeSet(cs);
+				}
+			}
+		}
+
+		bool parseInt(int& value)
+		{
+			auto start = pos;
+			value = 0;
+			while (!atEnd() && peek() >= '0' && peek() <= '9')
+			{
+				value = value * 10 + (peek() - '0');
+				if (value > static_cast<int>(MaxRepeat))
+					return false;
+				++pos;
+			}
+			return pos != start;
+		}
+
+		NodePtr parseRepeat()
+		{
+			auto atom = parseAtom();
+			while (!unsupported && !atEnd())
+			{
+				auto minRep = 0, maxRep = 0;
+				auto c = peek();
+				if (c == '*')
+					minRep = 0, maxRep = -1;
+				else if (c == '+')
+					minRep = 1, maxRep = -1;
+				else if (c == '?')
+					minRep = 0, maxRep = 1;
+				else if (c == '{')
+				{
+					++pos;
+					if (!parseInt(minRep))
+					{
+						unsupported = true;
+						break;
+					}
+					maxRep = minRep;
+					if (!atEnd() && peek() == ',')
+					{
+						++pos;
+						if (!atEnd() && peek() == '}')
+							maxRep = -1;
+						else if (!parseInt(maxRep) || maxRep < minRep)
+						{
+							unsupported = true;
+							break;
+						}
+					}
+					if (atEnd() || peek() != '}')
+					{
+						unsupported = true;
+						break;
+					}
+				}
+				else
+					break;
+				++pos;
+
+				// Lazy quantifiers change which match is reported
+				if (!atEnd() && peek() == '?')
+				{
+					unsupported = true;
+					break;
+				}
+
+				auto node = std::make_unique<Node>(Node::Repeat);
+				node->minRep = minRep;
+				node->maxRep = maxRep;
+				node->children.push_back(std::move(atom));
+				atom = std::move(node);
+
+				// ECMAScript does not allow stacking quantifiers like "a**"
+				if (!atEnd() && (peek() == '*' || peek() == '+' || peek() == '?' || peek() == '{'))
+					unsupported = true;
+			}
+			return atom;
+		}
+
+		NodePtr parseConcat()
+		{
+			auto node = std::make_unique<Node>(Node::Concat);
+			while (!unsupported && !atEnd() && peek() != '|' && peek() != ')')
+				node->children.push_back(parseRepeat());
+			return node;
+		}
+
+		NodePtr parseAlt()
+		{
+			auto node = std::make_unique<Node>(Node::Alt);
+			node->children.push_back(parseConcat());
+			while (!unsupported && !atEnd() && peek() == '|')
+			{
+				++pos;
+				node->children.push_back(parseConcat());
+			}
+			return node;
+		}
+	};
+
+	// Thompson NFA built from the AST
+	struct NFAState
+	{
+		int set = -1;
+		int out = -1;
+		std::vector<int> eps;
+	};
+	struct Fragment
+	{
+		int start, end;
+	};
+
+	enum : uint32_t
+	{
+		MaxRepeat = 1000,
+		MaxNFAStates = 1 << 16,
+		MaxDFAStates = 4096,
+		DeadState = 0,
+	};
+
+	static int addState(std::vector<NFAState>& nfa)
+	{
+		nfa.emplace_back();
+		return static_cast<int>(nfa.size() - 1);
+	}
+
+	static bool compileNode(const Node& node, std::vector<NFAState>& nfa, Fragment& frag)
+	{
+		if (nfa.size() > MaxNFAStates)
+			return false;
+
+		switch (node.kind)
+		{
+			case Node::Set:
+			{
+				auto s = addState(nfa);
+				auto e = addState(nfa);
+				nfa[s].set = static_cast<int>(node.set);
+				nfa[s].out = e;
+				frag = Fragment{ s, e };
+				return true;
+			}
+			case Node::Concat:
+			{
+				auto s = addState(nfa);
+				frag = Fragment{ s, s };
+				for (auto const& child: node.children)
+				{
+					auto sub = Fragment();
+					if (!compileNode(*child, nfa, sub))
+						return false;
+					nfa[frag.end].eps.push_back(sub.start);
+					frag.end = sub.end;
+				}
+				return true;
+			}
+			case Node::Alt:
+			{
+				auto s = addState(nfa);
+				auto e = addState(nfa);
+				for (auto const& child: node.children)
+				{
+					auto sub = Fragment();
+					if (!compileNode(*child, nfa, sub))
+						return false;
+					nfa[s].eps.push_back(sub.start);
+					nfa[sub.end].eps.push_back(e);
+				}
+				frag = Fragment{ s, e };
+				return true;
+			}
+			case Node::Repeat:
+			{
+				auto const& child = *node.children.front();
+				auto s = addState(nfa);
+				frag = Fragment{ s, s };
+				for (auto i = 0; i < node.minRep; ++i)
+				{
+					auto sub = Fragment();
+					if (!compileNode(child, nfa, sub))
+						return false;
+					nfa[frag.end].eps.push_back(sub.start);
+					frag.end = sub.end;
+				}
+
+				if (node.maxRep < 0)
+				{
+					auto loop = addState(nfa);
+					auto sub = Fragment();
+					if (!compileNode(child, nfa, sub))
+						return false;
+					nfa[frag.end].eps.push_back(loop);
+					nfa[loop].eps.push_back(sub.start);
+					nfa[sub.end].eps.push_back(loop);
+					frag.end = loop;
+				}
+				else if (node.maxRep > node.minRep)
+				{
+					auto e = addState(nfa);
+					for (auto i = node.minRep; i < node.maxRep; ++i)
+					{
+						auto sub = Fragment();
+						if (!compileNode(child, nfa, sub))
+							return false;
+						nfa[frag.end].eps.push_back(sub.start);
+						nfa[frag.end].eps.push_back(e);
+						frag.end = sub.end;
+					}
+					nfa[frag.end].eps.push_back(e);
+					frag.end = e;
+				}
+				return true;
+			}
+		}
+		return false;
+	}
+
+	static void closure(const std::vector<NFAState>& nfa, std::vector<int>& states, std::vector<char>& visited)
+	{
+		std::fill(visited.begin(), visited.end(), 0);
+		for (auto s: states)
+			visited[s] = 1;
+		for (auto i = 0u; i < states.size(); ++i)
+		{
+			for (auto next: nfa[states[i]].eps)
+			{
+				if (!visited[next])
+				{
+					visited[next] = 1;
+					states.push_back(next);
+				}
+			}
+		}
+
+		// Only states with a byte transition and the accepting state matter for identifying a DFA state
+		states.clear();
+		for (auto i = 0u; i < visited.size(); ++i)
+			if (visited[i])
+				states.push_back(static_cast<int>(i));
+	}
+
+	uint8_t byteClass[256];
+	size_t numClasses;
+	// State ids in the transition table are premultiplied by numClasses, so that the matching loop needs no multiplication. accepting is indexed by the same premultiplied ids, and holds 0 for a non-accepting state or 1 + the index of the first pattern that accepts.
+	std::vector<uint32_t> transitions;
+	std::vector<uint16_t> accepting;
+
+	RegexDFA() = default;
+
+	template <typename Range>
+	bool build(const Range& patterns)
+	{
+		auto sets = std::vector<CharSet>();
+		auto nfa = std::vector<NFAState>();
+		// With several patterns, the start state branches to each of them and each has its own final state
+		auto const start = addState(nfa);
+		auto finalStates = std::vector<int>();
+		for (auto const& pattern: patterns)
+		{
+			auto syntaxParser = RegexSyntaxParser(StringView(pattern), sets);
+			auto ast = syntaxParser.parseAlt();
+			if (syntaxParser.unsupported || !syntaxParser.atEnd())
+				return false;
+
+			auto frag = Fragment();
+			if (!compileNode(*ast, nfa, frag))
+				return false;
+			nfa[start].eps.push_back(frag.start);
+			finalStates.push_back(frag.end);
+		}
+		if (finalStates.empty() || finalStates.size() >= UINT16_MAX)
+			return false;
+
+		// Partition the bytes into classes that no character set can tell apart
+		auto classReps = std::vector<unsigned>{ 0 };
+		std::fill(std::begin(byteClass), std::end(byteClass), 0);
+		for (auto const& cs: sets)
+		{
+			auto remap = std::map<std::pair<unsigned, bool>, unsigned>();
+			auto newReps = std::vector<unsigned>();
+			for (auto b = 0u; b < 256; ++b)
+			{
+				auto key = std::make_pair(static_cast<unsigned>(byteClass[b]), static_cast<bool>(cs.test(b)));
+				auto itr = remap.find(key);
+				if (itr == remap.end())
+				{
+					itr = remap.emplace(key, static_cast<unsigned>(newReps.size())).first;
+					newReps.push_back(b);
+				}
+				byteClass[b] = static_cast<uint8_t>(itr->second);
+			}
+			classReps.swap(newReps);
+		}
+		numClasses = classReps.size();
+
+		// Subset construction. DFA state 0 is the dead state and state 1 is the start state.
+		auto visited = std::vector<char>(nfa.size());
+		auto stateIds = std::map<std::vector<int>, uint32_t>();
+		auto worklist = std::vector<std::vector<int>>();
+
+		auto intern = [&] (std::vector<int>&& states) -> uint32_t
+		{
+			if (states.empty())
+				return DeadState;
+			auto itr = stateIds.find(states);
+			if (itr != stateIds.end())
+				return itr->second;
+			auto id = static_cast<uint32_t>(worklist.size() + 1);
+			stateIds.emplace(states, id);
+			worklist.push_back(std::move(states));
+			return id;
+		};
+
+		transitions.assign(numClasses, DeadState);
+		auto acceptingStates = std::vector<uint16_t>(1, 0);
+
+		auto startSet = std::vector<int>{ start };
+		closure(nfa, startSet, visited);
+		intern(std::move(startSet));
+
+		for (auto i = 0u; i < worklist.size(); ++i)
+		{
+			if (worklist.size() > MaxDFAStates)
+				return false;
+
+			auto const current = worklist[i];
+			auto accept = uint16_t(0);
+			for (auto i = 0u; i < finalStates.size() && accept == 0; ++i)
+				if (std::binary_search(current.begin(), current.end(), finalStates[i]))
+					accept = static_cast<uint16_t>(i + 1);
+			acceptingStates.push_back(accept);
+			for (auto cls = 0u; cls < numClasses; ++cls)
+			{
+				auto next = std::vector<int>();
+				for (auto s: current)
+				{
+					auto const& state = nfa[s];
+					if (state.set >= 0 && sets[state.set].test(classReps[cls]))
+						next.push_back(state.out);
+				}
+				if (!next.empty())
+					closure(nfa, next, visited);
+				transitions.push_back(intern(std::move(next)) * static_cast<uint32_t>(numClasses));
+			}
+		}
+
+		accepting.assign(transitions.size(), 0);
+		for (auto i = 0u; i < acceptingStates.size(); ++i)
+			accepting[i * numClasses] = acceptingStates[i];
+		return true;
+	}
+public:
+	// Compile the pattern into a DFA. Return nullptr if the pattern uses features that need backtracking (back references, lookaheads, anchors, lazy quantifiers, ...) or is not understood.
+	static std::unique_ptr<RegexDFA> compile(StringView pattern)
+	{
+		auto dfa = std::unique_ptr<RegexDFA>(new RegexDFA());
+		if (!dfa->build(std::vector<StringView>{ pattern }))
+			return nullptr;
+		return dfa;
+	}
+
+	// Compile several patterns into one DFA, for longestMatchPattern()
+	template <typename Range>
+	static std::unique_ptr<RegexDFA> compileAll(const Range& patterns)
+	{
+		auto dfa = std::unique_ptr<RegexDFA>(new RegexDFA());
+		if (!dfa->build(patterns))
+			return nullptr;
+		return dfa;
+	}
+
+	// Return the length of the longest prefix of input that matches the pattern, or -1 if none does. reachedEnd is set if the whole input was read without reaching the dead state, i.e. if more input might give a longer match.
+	ptrdiff_t longestMatch(StringView input, bool& reachedEnd) const
+	{
+		auto state = static_cast<uint32_t>(numClasses);
+		auto matchLen = accepting[state] ? ptrdiff_t(0) : ptrdiff_t(-1);
+
+		reachedEnd = false;
+		auto const* data = reinterpret_cast<const unsigned char*>(input.data());
+		for (auto i = size_t(0), e = input.size(); i < e; ++i)
+		{
+			state = transitions[state + byteClass[data[i]]];
+			if (state == DeadState)
+				return matchLen;
+			if (accepting[state])
+				matchLen = static_cast<ptrdiff_t>(i + 1);
+		}
+		reachedEnd = true;
+		return matchLen;
+	}
+	ptrdiff_t longestMatch(StringView input) const
+	{
+		auto reachedEnd = false;
+		return longestMatch(input, reachedEnd);
+	}
+
+	// Return the length of the longest prefix of input that matches any of the patterns, and the index of the first pattern that matches that prefix, or (-1, -1) if none does. This is the maximal munch rule of lexers.
+	std::pair<ptrdiff_t, int> longestMatchPattern(StringView input) const
+	{
+		auto state = static_cast<uint32_t>(numClasses);
+		auto ret = std::make_pair(ptrdiff_t(-1), -1);
+		if (accepting[state])
+			ret = std::make_pair(ptrdiff_t(0), accepting[state] - 1);
+
+		auto const* data = reinterpret_cast<const unsigned char*>(input.data());
+		for (auto i = size_t(0), e = input.size(); i < e; ++i)
+		{
+			state = transitions[state + byteClass[data[i]]];
+			if (state == DeadState)
+				break;
+			if (accepting[state])
+				ret = std::make_pair(static_cast<ptrdiff_t>(i + 1), accepting[state] - 1);
+		}
+		return ret;
+	}
+
+	// The bytes that do not lead from the start state to the dead state
+	FirstSet getFirstSet() const
+	{
+		auto start = numClasses;
+		auto ret = FirstSet();
+		ret.setNullable(accepting[start]);
+		for (auto b = 0u; b < 256; ++b)
+			if (transitions[start + byteClass[b]] != DeadState)
+				ret.add(static_cast<char>(b));
+		return ret;
+	}
+
+	size_t getNumStates() const { return transitions.size() / numClasses; }
+};
+
+}	// end of namespace detail
+
+}
+
+#endif
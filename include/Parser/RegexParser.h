@@ -1,41 +1,98 @@
 #ifndef PCOMB_REGEX_PARSER_H
 #define PCOMB_REGEX_PARSER_H
 
+#include "Context/ParseContext.h"
 #include "Parser/Parser.h"
+#include "Parser/RegexDFA.h"
 
 #include <experimental/string_view>
+#include <memory>
 #include <regex>
+#include <string>
 
 namespace pcomb
 {
 
+namespace detail
+{
+
+// What a RegexParser is compiled into: the DFA if the pattern has one, the std::regex fallback otherwise, and the pattern itself to tell what was expected
+struct CompiledRegex
+{
+	std::unique_ptr<const RegexDFA> dfa;
+	std::regex regex;
+	std::string pattern;
+};
+
+}	// end of namespace detail
+
 // RegexParser takes a StringRef as regex and mathes the start of the input string against that regex.
 // RegexParser is strictly more powerful than StringParser. But I would expect that StringParser is cheaper.
+// The regex is compiled into a DFA once at construction, and the parser returns the longest matching prefix. Only patterns that need backtracking (back references, lookaheads, anchors, lazy quantifiers, ...) are handed to std::regex.
 class RegexParser: public Parser<std::experimental::string_view>
 {
 private:
 	using StringView = std::experimental::string_view;
-	std::regex regex;
+	// The compiled regex is immutable, so copies of the parser share it. dfa points into it, or is nullptr if the pattern needs std::regex, and saves an indirection per parse.
+	std::shared_ptr<const detail::CompiledRegex> compiled;
+	const detail::RegexDFA* dfa;
+
+	static std::shared_ptr<const detail::CompiledRegex> compile(StringView r)
+	{
+		auto ret = std::make_shared<detail::CompiledRegex>();
+		ret->dfa = detail::RegexDFA::compile(r);
+		if (!ret->dfa)
+			ret->regex = std::regex(r.begin(), r.end());
+		ret->pattern = r.to_string();
+		return ret;
+	}
 public:
 	using OutputType = StringView;
 	using ResultType = typename Parser<StringView>::ResultType;
 
-	RegexParser(StringView r): regex(r.data()) {}
+	RegexParser(StringView r): compiled(compile(r)), dfa(compiled->dfa.get()) {}
+
+	bool usesDFA() const { return dfa != nullptr; }
 
 	ResultType parse(const InputStream& input) const override final
 	{
 		auto ret = ResultType(input);
+		auto inputView = input.getInputStringView();
+
+		if (dfa != nullptr)
+		{
+			auto reachedEnd = false;
+			auto matchLen = dfa->longestMatch(inputView, reachedEnd);
+			if (reachedEnd)
+				noteEndReached(input);
+			if (matchLen >= 0)
+				ret = ResultType(input.consume(matchLen), inputView.substr(0, matchLen));
+			else
+				noteFailure(input, ExpectedItem::pattern(compiled->pattern));
+			return ret;
+		}
 
+		// std::regex cannot tell whether a failed match would succeed with more input, only that a match might go on
 		auto res = std::cmatch();
-		auto inputView = input.getInputStringView();
-		if (std::regex_search(inputView.begin(), inputView.end(), res, regex, std::regex_constants::match_continuous))
+		if (std::regex_search(inputView.begin(), inputView.end(), res, compiled->regex, std::regex_constants::match_continuous))
 		{
 			auto matchLen = res.length(0);
+			if (static_cast<size_t>(matchLen) == inputView.size())
+				noteEndReached(input);
 			ret = ResultType(input.consume(matchLen), inputView.substr(0, matchLen));
 		}
+		else
+			noteFailure(input, ExpectedItem::pattern(compiled->pattern));
 		
 		return ret;
 	}
+
+	FirstSet getFirstSet() const override final
+	{
+		if (dfa == nullptr)
+			return FirstSet::any();
+		return dfa->getFirstSet();
+	}
 };
 
 inline RegexParser regex(const std::experimental::string_view& s)
@@ -1,6 +1,7 @@
 #ifndef PCOMB_STRING_PARSER_H
 #define PCOMB_STRING_PARSER_H
 
+#include "Context/ParseContext.h"
 #include "Parser/Parser.h"
 
 #include <experimental/string_view>
@@ -24,12 +25,29 @@ public:
 	{
 		auto ret = ResultType(input);
 
-		auto inputView = std::experimental::string_view(input.getRawBuffer(), pattern.size());
+		// Never look past the end of the input: it may be the end of a file mapping
+		auto inputView = input.getInputStringView().substr(0, pattern.size());
 		if (pattern.compare(inputView) == 0)
 			ret = ResultType(input.consume(pattern.size()), inputView);
+		else
+		{
+			// The input ran out in the middle of the pattern
+			if (inputView.size() < pattern.size() && pattern.compare(0, inputView.size(), inputView) == 0)
+				noteEndReached(input);
+			noteFailure(input, ExpectedItem::literal(pattern));
+		}
 		
 		return ret;
 	}
+
+	FirstSet getFirstSet() const override final
+	{
+		if (pattern.empty())
+			return FirstSet::empty();
+		auto ret = FirstSet();
+		ret.add(pattern[0]);
+		return ret;
+	}
 };
 
 inline StringParser str(const std::experimental::string_view& s)
@@ -0,0 +1,80 @@
+#ifndef PCOMB_TOKEN_KIND_PARSER_H
+#define PCOMB_TOKEN_KIND_PARSER_H
+
+#include "Context/ParseContext.h"
+#include "InputStream/TokenArray.h"
+#include "Parser/Parser.h"
+
+#include <cassert>
+#include <experimental/string_view>
+
+namespace pcomb
+{
+
+// TokenKindParser runs over the stream of a TokenArray. It matches one token of the given kind and returns the text of that token in the source as its attribute.
+// The text is looked up in the TokenArray attached to the ParseContext, so the stream must come from TokenArray::getInputStream() with a context. recognize() only compares the kind and does without it.
+class TokenKindParser: public Parser<std::experimental::string_view>
+{
+private:
+	using StringView = std::experimental::string_view;
+
+	unsigned char kind;
+
+	bool matches(const InputStream& input) const
+	{
+		return !input.isEOF() && static_cast<unsigned char>(input.getRawBuffer()[0]) == kind;
+	}
+
+	void noteExpected(const InputStream& input) const
+	{
+		if (input.isEOF())
+			noteEndReached(input);
+		auto ctx = input.getContext();
+		if (ctx == nullptr || !ctx->isAtFurthestFailure(input.getOffset()))
+			return;
+		auto tokens = ctx->getTokens();
+		auto name = tokens != nullptr ? tokens->getKindName(kind) : StringView();
+		ctx->noteFailure(input.getOffset(), name.empty() ? ExpectedItem::character(static_cast<char>(kind)) : ExpectedItem::label(name));
+	}
+public:
+	using OutputType = StringView;
+	using ResultType = typename Parser<StringView>::ResultType;
+
+	TokenKindParser(unsigned char k): kind(k) {}
+
+	ResultType parse(const InputStream& input) const override final
+	{
+		if (matches(input))
+		{
+			auto ctx = input.getContext();
+			assert(ctx != nullptr && ctx->getTokens() != nullptr && "tok() needs the TokenArray in the ParseContext");
+			return ResultType(input.consume(1), ctx->getTokens()->getText(input.getOffset()));
+		}
+		noteExpected(input);
+		return ResultType(input);
+	}
+
+	RecognizeResult recognize(const InputStream& input) const override final
+	{
+		if (matches(input))
+			return RecognizeResult(input.consume(1), Ignored());
+		noteExpected(input);
+		return RecognizeResult(input);
+	}
+
+	FirstSet getFirstSet() const override final
+	{
+		auto ret = FirstSet();
+		ret.add(static_cast<char>(kind));
+		return ret;
+	}
+};
+
+inline TokenKindParser tok(unsigned char kind)
+{
+	return TokenKindParser(kind);
+}
+
+}
+
+#endif
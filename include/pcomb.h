@@ -2,17 +2,40 @@
 #define PCOMB_MAIN_HEADER_H
 
 // This is a header that pulls in all the headers for parsers and combinators
+#include "InputStream/ChunkedInput.h"
+#include "InputStream/Lexer.h"
+#include "InputStream/MappedFile.h"
+#include "InputStream/ParallelRecords.h"
+#include "InputStream/PushInput.h"
+
+#include "Parser/KeywordParser.h"
+#include "Parser/NumberParser.h"
 #include "Parser/PredicateCharParser.h"
 #include "Parser/RegexParser.h"
+#include "Parser/SpanParser.h"
 #include "Parser/StringParser.h"
+#include "Parser/TokenKindParser.h"
 
 #include "Combinator/AltParser.h"
+#include "Combinator/AnyParser.h"
 #include "Combinator/EnsembleParser.h"
+#include "Combinator/EventParser.h"
+#include "Combinator/IgnoreParser.h"
 #include "Combinator/SeqParser.h"
 #include "Combinator/ManyParser.h"
+#include "Combinator/FoldParser.h"
 #include "Combinator/TokenParser.h"
 #include "Combinator/ParserAdapter.h"
 #include "Combinator/LazyParser.h"
 #include "Combinator/LexemeParser.h"
+#include "Combinator/MatchedParser.h"
+#include "Combinator/MemoParser.h"
+#include "Combinator/NamedParser.h"
+#include "Combinator/OperatorParser.h"
+
+// Parsers keep their large immutable parts (char classes, compiled regexes, dispatch tables) behind shared pointers, so that the usual nodes of a grammar built at runtime fit in an AnyParser without a heap allocation
+static_assert(pcomb::IsStoredInline<decltype(pcomb::token(pcomb::regex("")))>::value, "token(regex()) should be stored inline by AnyParser");
+static_assert(pcomb::IsStoredInline<decltype(pcomb::alt(pcomb::ch('+'), pcomb::range('0', '9')))>::value, "alt() of two char parsers should be stored inline by AnyParser");
+static_assert(pcomb::IsStoredInline<decltype(pcomb::takeWhile(pcomb::detail::CharEqPredicate(' ')))>::value, "takeWhile() should be stored inline by AnyParser");
 
 #endif